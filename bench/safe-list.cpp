@@ -0,0 +1,216 @@
+/*
+ * Microbenchmark of wf::safe_list_t against its previous implementation, a
+ * std::list of std::unique_ptr whose erased elements were removed when the
+ * event loop went idle.
+ *
+ * Run without arguments. The results are printed in nanoseconds per element.
+ */
+#include <wayfire/nonstd/safe-list.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace old
+{
+/**
+ * The previous safe_list_t, trimmed to the operations being measured. The
+ * idle cleanup is run explicitly with idle(), where the event loop would
+ * have run it.
+ */
+template<class T>
+class safe_list_t
+{
+    std::list<std::unique_ptr<T>> list;
+    bool cleanup_scheduled = false;
+
+  public:
+    void push_back(T value)
+    {
+        list.push_back(std::make_unique<T>(std::move(value)));
+    }
+
+    void for_each(std::function<void(T&)> func) const
+    {
+        auto it = list.begin();
+        for (int size = list.size(); size > 0; size--, it++)
+        {
+            if (*it)
+            {
+                func(**it);
+            }
+        }
+    }
+
+    void remove_all(const T& value)
+    {
+        remove_if([=] (const T& el) { return el == value; });
+    }
+
+    void remove_if(std::function<bool(const T&)> predicate)
+    {
+        for (auto& it : list)
+        {
+            if (it && predicate(*it))
+            {
+                auto copy = std::move(it);
+                it = nullptr;
+                cleanup_scheduled = true;
+            }
+        }
+    }
+
+    void clear()
+    {
+        remove_if([] (const T&) { return true; });
+    }
+
+    void idle()
+    {
+        if (!cleanup_scheduled)
+        {
+            return;
+        }
+
+        list.remove_if([] (const auto& el) { return !el; });
+        cleanup_scheduled = false;
+    }
+};
+}
+
+namespace
+{
+/* The lists usually hold pointers, e.g. to signal callbacks */
+using element_t = int*;
+
+template<class List>
+void idle(List&)
+{}
+
+template<class T>
+void idle(old::safe_list_t<T>& list)
+{
+    list.idle();
+}
+
+/** Time the function, in nanoseconds per operation */
+template<class Func>
+double measure(size_t operations, Func func)
+{
+    /* Warm up */
+    func();
+
+    int rounds = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto now   = start;
+    while (now - start < std::chrono::milliseconds(200))
+    {
+        func();
+        ++rounds;
+        now = std::chrono::steady_clock::now();
+    }
+
+    auto ns = std::chrono::duration<double, std::nano>(now - start).count();
+
+    return ns / rounds / operations;
+}
+
+template<class List>
+void fill(List& list, std::vector<int>& storage)
+{
+    for (auto& el : storage)
+    {
+        list.push_back(&el);
+    }
+}
+
+/** Iterate over the whole list */
+template<class List>
+double bench_for_each(size_t n)
+{
+    std::vector<int> storage(n, 1);
+    List list;
+    fill(list, storage);
+
+    volatile long sum = 0;
+
+    return measure(n, [&] ()
+    {
+        long local = 0;
+        list.for_each([&] (element_t& el) { local += *el; });
+        sum = sum + local;
+    });
+}
+
+/**
+ * Remove every other element from within the iteration, as a signal handler
+ * disconnecting itself would, then let the event loop go idle and refill.
+ */
+template<class List>
+double bench_remove_during_iteration(size_t n)
+{
+    std::vector<int> storage(n, 1);
+    List list;
+
+    return measure(n, [&] ()
+    {
+        fill(list, storage);
+        size_t index = 0;
+        list.for_each([&] (element_t& el)
+        {
+            if (index++ % 2 == 0)
+            {
+                auto copy = el;
+                list.remove_all(copy);
+            }
+        });
+
+        list.clear();
+        idle(list);
+    });
+}
+
+/** Build the list from scratch */
+template<class List>
+double bench_push_back(size_t n)
+{
+    std::vector<int> storage(n, 1);
+
+    return measure(n, [&] ()
+    {
+        List list;
+        fill(list, storage);
+    });
+}
+}
+
+int main()
+{
+    using new_list = wf::safe_list_t<element_t>;
+    using old_list = old::safe_list_t<element_t>;
+
+    std::printf("%-28s %8s %12s %12s %8s\n",
+        "benchmark (ns/element)", "size", "std::list", "vector", "speedup");
+
+    auto report = [] (const char *name, size_t n, double old_ns, double new_ns)
+    {
+        std::printf("%-28s %8zu %12.2f %12.2f %7.1fx\n",
+            name, n, old_ns, new_ns, old_ns / new_ns);
+    };
+
+    for (size_t n : {8, 64, 1024})
+    {
+        report("for_each", n,
+            bench_for_each<old_list>(n), bench_for_each<new_list>(n));
+        report("remove during iteration", n,
+            bench_remove_during_iteration<old_list>(n),
+            bench_remove_during_iteration<new_list>(n));
+        report("push_back", n,
+            bench_push_back<old_list>(n), bench_push_back<new_list>(n));
+    }
+
+    return 0;
+}
@@ -44,7 +44,7 @@ struct animation_hook : public animation_hook_base
     std::unique_ptr<animation_base> animation;
 
     /* Update animation right before each frame */
-    wf::effect_hook_t update_animation_hook = [=] ()
+    wf::animation_hook_t update_animation_hook = [=] ()
     {
         view->damage();
         bool result = animation->step();
@@ -54,6 +54,8 @@ struct animation_hook : public animation_hook_base
         {
             stop_hook(false);
         }
+
+        return result;
     };
 
     /**
@@ -64,13 +66,12 @@ struct animation_hook : public animation_hook_base
     {
         if (current_output)
         {
-            current_output->render->rem_effect(&update_animation_hook);
+            current_output->render->rem_animation(&update_animation_hook);
         }
 
         if (new_output)
         {
-            new_output->render->add_effect(&update_animation_hook,
-                wf::OUTPUT_EFFECT_PRE);
+            new_output->render->add_animation(&update_animation_hook);
         }
 
         current_output = new_output;
@@ -1,5 +1,6 @@
 #include "blur.hpp"
 #include <wayfire/output.hpp>
+#include <wayfire/output-layout.hpp>
 #include <wayfire/workspace-manager.hpp>
 #include <wayfire/util/log.hpp>
 
@@ -38,16 +39,22 @@ void main()
     gl_FragColor = wp + (1.0 - wp.a) * c;
 })";
 
-wf_blur_base::wf_blur_base(wf::output_t *output, std::string name)
+wf_blur_base::wf_blur_base(std::string name)
 {
-    this->output = output;
     this->algorithm_name = name;
 
     this->offset_opt.load_option("blur/" + algorithm_name + "_offset");
     this->degrade_opt.load_option("blur/" + algorithm_name + "_degrade");
     this->iterations_opt.load_option("blur/" + algorithm_name + "_iterations");
 
-    this->options_changed = [=] () { output->render->damage_whole(); };
+    /* The algorithm is shared between all outputs */
+    this->options_changed = [=] ()
+    {
+        for (auto& output : wf::get_core().output_layout->get_outputs())
+        {
+            output->render->damage_whole();
+        }
+    };
     this->offset_opt.set_callback(options_changed);
     this->degrade_opt.set_callback(options_changed);
     this->iterations_opt.set_callback(options_changed);
@@ -247,31 +254,30 @@ void wf_blur_base::render(wf::texture_t src_tex, wlr_box src_box,
     OpenGL::render_end();
 }
 
-std::unique_ptr<wf_blur_base> create_blur_from_name(wf::output_t *output,
-    std::string algorithm_name)
+std::unique_ptr<wf_blur_base> create_blur_from_name(std::string algorithm_name)
 {
     if (algorithm_name == "box")
     {
-        return create_box_blur(output);
+        return create_box_blur();
     }
 
     if (algorithm_name == "bokeh")
     {
-        return create_bokeh_blur(output);
+        return create_bokeh_blur();
     }
 
     if (algorithm_name == "kawase")
     {
-        return create_kawase_blur(output);
+        return create_kawase_blur();
     }
 
     if (algorithm_name == "gaussian")
     {
-        return create_gaussian_blur(output);
+        return create_gaussian_blur();
     }
 
     LOGE("Unrecognized blur algorithm %s. Using default kawase blur.",
         algorithm_name.c_str());
 
-    return create_kawase_blur(output);
+    return create_kawase_blur();
 }
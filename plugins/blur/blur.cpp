@@ -5,6 +5,8 @@
 #include <wayfire/workspace-stream.hpp>
 #include <wayfire/workspace-manager.hpp>
 #include <wayfire/signal-definitions.hpp>
+#include <wayfire/output-layout.hpp>
+#include <wayfire/plugins/common/shared-core-data.hpp>
 
 #include "blur.hpp"
 
@@ -52,6 +54,19 @@ class wf_blur_transformer : public wf::view_transformer_t
         return wf::TRANSFORMER_BLUR;
     }
 
+    /* Blur does not move the view, so the transformation never changes */
+    uint64_t get_transform_serial() override
+    {
+        return 1;
+    }
+
+    bool get_affine_transform(wf::geometry_t view, glm::mat3& matrix) override
+    {
+        matrix = glm::mat3(1.0);
+
+        return true;
+    }
+
     /* Render without blending */
     void direct_render(wf::texture_t src_tex, wlr_box src_box,
         const wf::region_t& damage, const wf::framebuffer_t& target_fb)
@@ -112,6 +127,35 @@ class wf_blur_transformer : public wf::view_transformer_t
     }
 };
 
+/**
+ * The blur algorithm does not depend on the output, so a single instance (and
+ * its GL programs) is shared between all outputs.
+ */
+class blur_algorithm_holder_t
+{
+  public:
+    std::unique_ptr<wf_blur_base> algorithm;
+
+    blur_algorithm_holder_t()
+    {
+        method_changed = [=] ()
+        {
+            algorithm = create_blur_from_name(method_opt);
+            for (auto& output : wf::get_core().output_layout->get_outputs())
+            {
+                output->render->damage_whole();
+            }
+        };
+        /* Create initial blur algorithm */
+        algorithm = create_blur_from_name(method_opt);
+        method_opt.set_callback(method_changed);
+    }
+
+  private:
+    wf::option_wrapper_t<std::string> method_opt{"blur/method"};
+    wf::config::option_base_t::updated_callback_t method_changed;
+};
+
 class wayfire_blur : public wf::plugin_interface_t
 {
     wf::button_callback button_toggle;
@@ -123,11 +167,10 @@ class wayfire_blur : public wf::plugin_interface_t
     const std::string normal_mode = "normal";
     std::string last_mode;
 
-    wf::option_wrapper_t<std::string> method_opt{"blur/method"},
-    mode_opt{"blur/mode"};
+    wf::option_wrapper_t<std::string> mode_opt{"blur/mode"};
     wf::option_wrapper_t<wf::buttonbinding_t> toggle_button{"blur/toggle"};
-    wf::config::option_base_t::updated_callback_t blur_method_changed, mode_changed;
-    std::unique_ptr<wf_blur_base> blur_algorithm;
+    wf::config::option_base_t::updated_callback_t mode_changed;
+    wf::shared_data::ref_ptr_t<blur_algorithm_holder_t> blur;
 
     const std::string transformer_name = "blur";
 
@@ -143,7 +186,7 @@ class wayfire_blur : public wf::plugin_interface_t
         }
 
         view->add_transformer(std::make_unique<wf_blur_transformer>(
-            [=] () {return nonstd::make_observer(blur_algorithm.get()); },
+            [=] () {return nonstd::make_observer(blur->algorithm.get()); },
             output, view),
             transformer_name);
     }
@@ -184,15 +227,6 @@ class wayfire_blur : public wf::plugin_interface_t
         grab_interface->name = "blur";
         grab_interface->capabilities = 0;
 
-        blur_method_changed = [=] ()
-        {
-            blur_algorithm = create_blur_from_name(output, method_opt);
-            output->render->damage_whole();
-        };
-        /* Create initial blur algorithm */
-        blur_method_changed();
-        method_opt.set_callback(blur_method_changed);
-
         /* Default mode is normal, which means attach the blur transformer
          * to each view on the output. If on toggle, this means that the user
          * has to manually click on the views they want to blur */
@@ -297,7 +331,7 @@ class wayfire_blur : public wf::plugin_interface_t
             const auto& fb = output->render->get_target_framebuffer();
 
             int padding = std::ceil(
-                blur_algorithm->calculate_blur_radius() / fb.scale);
+                blur->algorithm->calculate_blur_radius() / fb.scale);
             wf::surface_interface_t::set_opaque_shrink_constraint("blur",
                 padding);
 
@@ -332,7 +366,7 @@ class wayfire_blur : public wf::plugin_interface_t
              * furthest sampled pixel by the shader, there should
              * be no visual artifacts. */
             int padding = std::ceil(
-                blur_algorithm->calculate_blur_radius() / target_fb.scale);
+                blur->algorithm->calculate_blur_radius() / target_fb.scale);
 
             wf::region_t expanded_damage;
             for (const auto& rect : damage)
@@ -431,8 +465,11 @@ class wayfire_blur : public wf::plugin_interface_t
         output->render->disconnect_signal("workspace-stream-post",
             &workspace_stream_post);
 
-        /* Call blur algorithm destructor */
-        blur_algorithm = nullptr;
+        /* Call blur algorithm destructor if this is the last instance */
+        if (blur.get_use_count() == 1)
+        {
+            blur->algorithm = nullptr;
+        }
 
         OpenGL::render_begin();
         saved_pixels.release();
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <wayfire/core.hpp>
+#include <wayfire/nonstd/noncopyable.hpp>
+
+namespace wf
+{
+namespace shared_data
+{
+namespace detail
+{
+template<class T>
+struct shared_data_t : public wf::custom_data_t
+{
+    T data;
+    int32_t use_count = 0;
+};
+}
+
+/**
+ * A reference to an object which is shared between all plugin instances.
+ *
+ * Plugins are instantiated once per output, but many of their resources, for
+ * ex. OpenGL programs, do not depend on the output. Since all outputs render
+ * with the same GL context, each per-output instance can hold a ref_ptr_t to
+ * a single object instead of creating its own copy.
+ *
+ * The object is stored as custom data on core. It is default-constructed
+ * when the first ref_ptr_t is created, and destroyed when the last ref_ptr_t
+ * is destroyed.
+ */
+template<class T>
+class ref_ptr_t : public noncopyable_t
+{
+  public:
+    ref_ptr_t()
+    {
+        update_use_count(+1);
+        this->ptr = &wf::get_core().get_data_safe<detail::shared_data_t<T>>()->data;
+    }
+
+    ~ref_ptr_t()
+    {
+        update_use_count(-1);
+    }
+
+    /** @return The number of ref_ptr_t objects referencing the shared object */
+    int32_t get_use_count()
+    {
+        return wf::get_core().get_data_safe<detail::shared_data_t<T>>()->use_count;
+    }
+
+    T *get()
+    {
+        return ptr;
+    }
+
+    T *operator ->()
+    {
+        return ptr;
+    }
+
+    T& operator *()
+    {
+        return *ptr;
+    }
+
+  private:
+    T *ptr;
+
+    void update_use_count(int32_t delta)
+    {
+        auto instance = wf::get_core().get_data_safe<detail::shared_data_t<T>>();
+        instance->use_count += delta;
+        if (instance->use_count <= 0)
+        {
+            wf::get_core().erase_data<detail::shared_data_t<T>>();
+        }
+    }
+};
+}
+}
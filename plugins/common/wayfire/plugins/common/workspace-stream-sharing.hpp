@@ -77,15 +77,19 @@ class workspace_stream_pool_t : public noncopyable_t, public wf::custom_data_t
      * Update the contents of the given workspace.
      *
      * If the workspace has not been started before, it will be started.
+     *
+     * @param scale The resolution at which to render the workspace, relative
+     *   to the output resolution. See render_manager::workspace_stream_update().
      */
-    void update(wf::point_t workspace)
+    void update(wf::point_t workspace, float scale = 1.0)
     {
         auto& stream = get(workspace);
         if (stream.running)
         {
-            output->render->workspace_stream_update(stream);
+            output->render->workspace_stream_update(stream, scale, scale);
         } else
         {
+            stream.scale_x = stream.scale_y = scale;
             output->render->workspace_stream_start(stream);
         }
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 #include "workspace-stream-sharing.hpp"
 
@@ -102,7 +103,7 @@ class workspace_wall_t : public wf::signal_provider_t
      */
     void render_wall(const wf::framebuffer_t& fb, wf::geometry_t geometry)
     {
-        update_streams();
+        update_streams(get_stream_scale(geometry));
 
         OpenGL::render_begin(fb);
         fb.logic_scissor(geometry);
@@ -204,14 +205,39 @@ class workspace_wall_t : public wf::signal_provider_t
     nonstd::observer_ptr<workspace_stream_pool_t> streams;
 
     /** Update or start visible streams */
-    void update_streams()
+    void update_streams(float scale)
     {
         for (auto& ws : get_visible_workspaces(viewport))
         {
-            streams->update(ws);
+            streams->update(ws, scale);
         }
     }
 
+    /**
+     * Calculate the resolution at which workspaces need to be rendered, so
+     * that they are not scaled up when drawn on the given geometry.
+     *
+     * The scale is rounded up to 1/N, so that streams are not reallocated and
+     * repainted on each frame while zooming. Once the wall is zoomed in enough,
+     * the streams are rendered at full resolution.
+     */
+    float get_stream_scale(wf::geometry_t target) const
+    {
+        if ((viewport.width <= 0) || (viewport.height <= 0))
+        {
+            return 1.0;
+        }
+
+        double scale = std::max(1.0 * target.width / viewport.width,
+            1.0 * target.height / viewport.height);
+        if (scale >= 1.0)
+        {
+            return 1.0;
+        }
+
+        return 1.0 / std::floor(1.0 / scale);
+    }
+
     /**
      * Get a list of workspaces visible in the viewport.
      */
@@ -7,6 +7,7 @@
 #include <wayfire/workspace-manager.hpp>
 
 #include <wayfire/plugins/common/workspace-stream-sharing.hpp>
+#include <wayfire/plugins/common/shared-core-data.hpp>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <wayfire/img.hpp>
@@ -30,6 +31,70 @@
 #include "shaders.tpp"
 #include "shaders-3-2.tpp"
 
+/**
+ * The cube program does not depend on the output, so it is compiled only once
+ * and shared between all outputs.
+ */
+class cube_program_t
+{
+  public:
+    OpenGL::program_t program;
+    bool tessellation_support = false;
+
+    /** Compile the program, if it has not been compiled yet. */
+    void ensure_loaded()
+    {
+        if (program.get_program_id(wf::TEXTURE_TYPE_RGBA) != 0)
+        {
+            return;
+        }
+
+#ifdef USE_GLES32
+        std::string ext_string(reinterpret_cast<const char*>(glGetString(
+            GL_EXTENSIONS)));
+        tessellation_support =
+            ext_string.find(std::string("GL_EXT_tessellation_shader")) !=
+            std::string::npos;
+#else
+        tessellation_support = false;
+#endif
+
+        if (!tessellation_support)
+        {
+            program.set_simple(OpenGL::compile_program(
+                cube_vertex_2_0, cube_fragment_2_0));
+        } else
+        {
+#ifdef USE_GLES32
+            auto id = GL_CALL(glCreateProgram());
+            GLuint vss, fss, tcs, tes, gss;
+
+            vss = OpenGL::compile_shader(cube_vertex_3_2, GL_VERTEX_SHADER);
+            fss = OpenGL::compile_shader(cube_fragment_3_2, GL_FRAGMENT_SHADER);
+            tcs = OpenGL::compile_shader(cube_tcs_3_2, GL_TESS_CONTROL_SHADER);
+            tes = OpenGL::compile_shader(cube_tes_3_2, GL_TESS_EVALUATION_SHADER);
+            gss = OpenGL::compile_shader(cube_geometry_3_2, GL_GEOMETRY_SHADER);
+
+            GL_CALL(glAttachShader(id, vss));
+            GL_CALL(glAttachShader(id, tcs));
+            GL_CALL(glAttachShader(id, tes));
+            GL_CALL(glAttachShader(id, gss));
+            GL_CALL(glAttachShader(id, fss));
+
+            GL_CALL(glLinkProgram(id));
+            GL_CALL(glUseProgram(id));
+
+            GL_CALL(glDeleteShader(vss));
+            GL_CALL(glDeleteShader(fss));
+            GL_CALL(glDeleteShader(tcs));
+            GL_CALL(glDeleteShader(tes));
+            GL_CALL(glDeleteShader(gss));
+            program.set_simple(id);
+#endif
+        }
+    }
+};
+
 class wayfire_cube : public wf::plugin_interface_t
 {
     wf::button_callback activate_binding;
@@ -49,7 +114,7 @@ class wayfire_cube : public wf::plugin_interface_t
      * for the given FOV */
     float identity_z_offset;
 
-    OpenGL::program_t program;
+    wf::shared_data::ref_ptr_t<cube_program_t> shared;
 
     wf_cube_animation_attribs animation;
     wf::option_wrapper_t<bool> use_light{"cube/light"};
@@ -90,8 +155,6 @@ class wayfire_cube : public wf::plugin_interface_t
         }
     }
 
-    bool tessellation_support;
-
     int get_num_faces()
     {
         return output->workspace->get_workspace_grid_size().width;
@@ -170,55 +233,8 @@ class wayfire_cube : public wf::plugin_interface_t
         renderer = [=] (const wf::framebuffer_t& dest) {render(dest);};
 
         OpenGL::render_begin(output->render->get_target_framebuffer());
-        load_program();
+        shared->ensure_loaded();
         OpenGL::render_end();
-    }
-
-    void load_program()
-    {
-#ifdef USE_GLES32
-        std::string ext_string(reinterpret_cast<const char*>(glGetString(
-            GL_EXTENSIONS)));
-        tessellation_support =
-            ext_string.find(std::string("GL_EXT_tessellation_shader")) !=
-            std::string::npos;
-#else
-        tessellation_support = false;
-#endif
-
-        if (!tessellation_support)
-        {
-            program.set_simple(OpenGL::compile_program(
-                cube_vertex_2_0, cube_fragment_2_0));
-        } else
-        {
-#ifdef USE_GLES32
-            auto id = GL_CALL(glCreateProgram());
-            GLuint vss, fss, tcs, tes, gss;
-
-            vss = OpenGL::compile_shader(cube_vertex_3_2, GL_VERTEX_SHADER);
-            fss = OpenGL::compile_shader(cube_fragment_3_2, GL_FRAGMENT_SHADER);
-            tcs = OpenGL::compile_shader(cube_tcs_3_2, GL_TESS_CONTROL_SHADER);
-            tes = OpenGL::compile_shader(cube_tes_3_2, GL_TESS_EVALUATION_SHADER);
-            gss = OpenGL::compile_shader(cube_geometry_3_2, GL_GEOMETRY_SHADER);
-
-            GL_CALL(glAttachShader(id, vss));
-            GL_CALL(glAttachShader(id, tcs));
-            GL_CALL(glAttachShader(id, tes));
-            GL_CALL(glAttachShader(id, gss));
-            GL_CALL(glAttachShader(id, fss));
-
-            GL_CALL(glLinkProgram(id));
-            GL_CALL(glUseProgram(id));
-
-            GL_CALL(glDeleteShader(vss));
-            GL_CALL(glDeleteShader(fss));
-            GL_CALL(glDeleteShader(tcs));
-            GL_CALL(glDeleteShader(tes));
-            GL_CALL(glDeleteShader(gss));
-            program.set_simple(id);
-#endif
-        }
 
         streams = wf::workspace_stream_pool_t::ensure_pool(output);
         animation.projection = glm::perspective(45.0f, 1.f, 0.1f, 100.f);
@@ -480,9 +496,9 @@ class wayfire_cube : public wf::plugin_interface_t
                 streams->get({index, cws.y}).buffer.tex));
 
             auto model = calculate_model_matrix(i, fb_transform);
-            program.uniformMatrix4f("model", model);
+            shared->program.uniformMatrix4f("model", model);
 
-            if (tessellation_support)
+            if (shared->tessellation_support)
             {
 #ifdef USE_GLES32
                 GL_CALL(glDrawElements(GL_PATCHES, 6, GL_UNSIGNED_INT, &indexData));
@@ -498,10 +514,7 @@ class wayfire_cube : public wf::plugin_interface_t
     void render(const wf::framebuffer_t& dest)
     {
         update_workspace_streams();
-        if (program.get_program_id(wf::TEXTURE_TYPE_RGBA) == 0)
-        {
-            load_program();
-        }
+        shared->ensure_loaded();
 
         OpenGL::render_begin(dest);
         GL_CALL(glClear(GL_DEPTH_BUFFER_BIT));
@@ -513,7 +526,7 @@ class wayfire_cube : public wf::plugin_interface_t
         auto vp = calculate_vp_matrix(dest);
 
         OpenGL::render_begin(dest);
-        program.use(wf::TEXTURE_TYPE_RGBA);
+        shared->program.use(wf::TEXTURE_TYPE_RGBA);
         GL_CALL(glEnable(GL_DEPTH_TEST));
         GL_CALL(glDepthFunc(GL_LESS));
 
@@ -531,14 +544,14 @@ class wayfire_cube : public wf::plugin_interface_t
             0.0f, 0.0f
         };
 
-        program.attrib_pointer("position", 2, 0, vertexData);
-        program.attrib_pointer("uvPosition", 2, 0, coordData);
-        program.uniformMatrix4f("VP", vp);
-        if (tessellation_support)
+        shared->program.attrib_pointer("position", 2, 0, vertexData);
+        shared->program.attrib_pointer("uvPosition", 2, 0, coordData);
+        shared->program.uniformMatrix4f("VP", vp);
+        if (shared->tessellation_support)
         {
-            program.uniform1i("deform", use_deform);
-            program.uniform1i("light", use_light);
-            program.uniform1f("ease",
+            shared->program.uniform1i("deform", use_deform);
+            shared->program.uniform1i("light", use_light);
+            shared->program.uniform1f("ease",
                 animation.cube_animation.ease_deformation);
         }
 
@@ -552,7 +565,7 @@ class wayfire_cube : public wf::plugin_interface_t
         GL_CALL(glDisable(GL_CULL_FACE));
 
         GL_CALL(glDisable(GL_DEPTH_TEST));
-        program.deactivate();
+        shared->program.deactivate();
         OpenGL::render_end();
 
         update_view_matrix();
@@ -635,9 +648,13 @@ class wayfire_cube : public wf::plugin_interface_t
 
         streams->unref();
 
-        OpenGL::render_begin();
-        program.free_resources();
-        OpenGL::render_end();
+        /* The program is destroyed together with the last instance */
+        if (shared.get_use_count() == 1)
+        {
+            OpenGL::render_begin();
+            shared->program.free_resources();
+            OpenGL::render_end();
+        }
 
         output->rem_binding(&activate_binding);
         output->rem_binding(&rotate_left);
@@ -0,0 +1,512 @@
+#include <wayfire/plugin.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/opengl.hpp>
+#include <wayfire/render-manager.hpp>
+#include <wayfire/workspace-manager.hpp>
+#include <wayfire/frame-stats.hpp>
+#include <wayfire/view.hpp>
+#include <wayfire/plugins/common/cairo-util.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+
+#include <deque>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <chrono>
+
+namespace
+{
+using steady_clock = std::chrono::steady_clock;
+
+/** Number of frames shown in the graphs */
+constexpr size_t GRAPH_FRAMES = 120;
+/** Size of the HUD panel, in logical pixels */
+constexpr int PANEL_WIDTH  = 440;
+constexpr int PANEL_HEIGHT = 360;
+constexpr int PANEL_MARGIN = 10;
+/** How often the panel contents are refreshed */
+constexpr uint32_t REFRESH_INTERVAL_MS = 100;
+
+std::string format_msec(int64_t usec)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << usec / 1000.0;
+
+    return out.str();
+}
+
+int64_t region_area(const wf::region_t& region)
+{
+    int64_t area = 0;
+    for (const auto& box : region)
+    {
+        area += int64_t(box.x2 - box.x1) * int64_t(box.y2 - box.y1);
+    }
+
+    return area;
+}
+
+/** A repainted region of the output, shown in the damage heatmap */
+struct heatmap_entry_t
+{
+    wf::region_t region;
+    steady_clock::time_point time;
+};
+
+/** The work done by the HUD itself during a frame */
+struct own_cost_t
+{
+    int64_t usec = 0;
+    uint64_t draw_calls    = 0;
+    uint64_t render_passes = 0;
+};
+}
+
+class wayfire_hud : public wf::plugin_interface_t
+{
+    wf::option_wrapper_t<wf::activatorbinding_t> toggle_key{"hud/toggle"};
+    wf::option_wrapper_t<wf::activatorbinding_t> toggle_heatmap_key{
+        "hud/toggle_heatmap"};
+    wf::option_wrapper_t<int> heatmap_duration{"hud/heatmap_duration"};
+
+    bool active  = false;
+    bool heatmap = false;
+
+    wf::simple_texture_t panel;
+    bool panel_dirty = true;
+    wf::wl_timer refresh_timer;
+
+    /* Damage caused by the HUD for the next frame, in output-local logical
+     * coordinates. It is excluded from the measured damage. */
+    wf::region_t own_damage;
+    /* Cost of the HUD in the previous frame, subtracted from the render
+     * statistics of that frame */
+    own_cost_t last_own_cost;
+    /* Whether the previous frame repainted anything besides the HUD */
+    bool last_frame_had_scene = false;
+
+    /* Samples for the graphs, with the HUD's own cost removed */
+    std::deque<int64_t> cpu_samples;
+    std::deque<int64_t> gpu_samples;
+    wf::frame_render_stats_t latest;
+    int64_t latest_damage_area = 0;
+
+    std::deque<heatmap_entry_t> heatmap_entries;
+
+  public:
+    void init() override
+    {
+        grab_interface->name = "hud";
+        grab_interface->capabilities = 0;
+
+        output->add_activator(toggle_key, &toggle_cb);
+        output->add_activator(toggle_heatmap_key, &toggle_heatmap_cb);
+    }
+
+    wf::activator_callback toggle_cb = [=] (wf::activator_source_t, uint32_t)
+    {
+        set_active(!active);
+
+        return true;
+    };
+
+    wf::activator_callback toggle_heatmap_cb =
+        [=] (wf::activator_source_t, uint32_t)
+    {
+        heatmap = !heatmap;
+        heatmap_entries.clear();
+        if (heatmap && !active)
+        {
+            set_active(true);
+        }
+
+        damage_own(output->get_relative_geometry());
+
+        return true;
+    };
+
+    void set_active(bool state)
+    {
+        if (state == active)
+        {
+            return;
+        }
+
+        active = state;
+        if (active)
+        {
+            cpu_samples.clear();
+            gpu_samples.clear();
+            last_own_cost = {};
+            last_frame_had_scene = false;
+            panel_dirty = true;
+            output->render->add_effect(&overlay_hook, wf::OUTPUT_EFFECT_OVERLAY);
+            damage_own(get_panel_geometry());
+        } else
+        {
+            output->render->rem_effect(&overlay_hook);
+            refresh_timer.disconnect();
+            heatmap = false;
+            heatmap_entries.clear();
+            output->render->damage_whole();
+            own_damage.clear();
+        }
+    }
+
+    wf::geometry_t get_panel_geometry()
+    {
+        return {PANEL_MARGIN, PANEL_MARGIN, PANEL_WIDTH, PANEL_HEIGHT};
+    }
+
+    /** Damage a part of the output and remember that the HUD caused it */
+    void damage_own(const wf::region_t& region)
+    {
+        own_damage |= region;
+        output->render->damage(region);
+    }
+
+    wf::effect_hook_t overlay_hook = [=] ()
+    {
+        auto start = steady_clock::now();
+        auto counters_start = OpenGL::get_render_counters();
+
+        /* The damage of this frame, without the parts the HUD damaged itself */
+        float scale = output->handle->scale;
+        wf::region_t damage = output->render->get_swap_damage() * (1.0 / scale);
+        wf::region_t scene_damage = damage ^ own_damage;
+        own_damage.clear();
+
+        collect_stats(scene_damage);
+        if (heatmap && !scene_damage.empty())
+        {
+            heatmap_entries.push_back({scene_damage, start});
+        }
+
+        auto fb = output->render->get_target_framebuffer();
+        if (heatmap)
+        {
+            render_heatmap(fb, damage, start);
+        }
+
+        if (panel_dirty)
+        {
+            update_panel();
+            panel_dirty = false;
+        }
+
+        render_panel(fb, damage);
+        schedule_refresh();
+
+        auto& counters = OpenGL::get_render_counters();
+        last_own_cost.usec = std::chrono::duration_cast<std::chrono::microseconds>(
+            steady_clock::now() - start).count();
+        last_own_cost.draw_calls =
+            counters.draw_calls - counters_start.draw_calls;
+        last_own_cost.render_passes =
+            counters.render_passes - counters_start.render_passes;
+    };
+
+    /**
+     * Record the statistics of the previous frame, and remember whether this
+     * frame is worth recording.
+     */
+    void collect_stats(const wf::region_t& scene_damage)
+    {
+        if (last_frame_had_scene)
+        {
+            /* Frames which only repainted the HUD are not interesting */
+            latest = output->render->get_render_stats();
+            latest.paint_usec -= std::min(latest.paint_usec, last_own_cost.usec);
+            latest.stage_usec[wf::FRAME_STAGE_OVERLAY] -= std::min(
+                latest.stage_usec[wf::FRAME_STAGE_OVERLAY], last_own_cost.usec);
+            latest.draw_calls -= std::min(latest.draw_calls,
+                last_own_cost.draw_calls);
+            latest.render_passes -= std::min(latest.render_passes,
+                last_own_cost.render_passes);
+
+            push_sample(cpu_samples, latest.paint_usec);
+            push_sample(gpu_samples, std::max<int64_t>(latest.gpu_usec, 0));
+        }
+
+        float scale = output->handle->scale;
+        last_frame_had_scene = !scene_damage.empty();
+        if (last_frame_had_scene)
+        {
+            latest_damage_area = region_area(scene_damage * scale);
+        }
+    }
+
+    void push_sample(std::deque<int64_t>& samples, int64_t value)
+    {
+        samples.push_back(value);
+        if (samples.size() > GRAPH_FRAMES)
+        {
+            samples.pop_front();
+        }
+    }
+
+    /** Refresh the panel regularly, but not on every frame */
+    void schedule_refresh()
+    {
+        if (refresh_timer.is_connected())
+        {
+            return;
+        }
+
+        refresh_timer.set_timeout(REFRESH_INTERVAL_MS, [=] ()
+        {
+            refresh_timer.disconnect();
+            panel_dirty = true;
+            damage_own(get_panel_geometry());
+        });
+    }
+
+    void render_heatmap(const wf::framebuffer_t& fb, const wf::region_t& damage,
+        steady_clock::time_point now)
+    {
+        auto duration = std::chrono::milliseconds(
+            std::max(1, (int)heatmap_duration));
+        while (!heatmap_entries.empty() &&
+               (now - heatmap_entries.front().time > duration))
+        {
+            /* Repaint once more to remove the last trace of it */
+            damage_own(heatmap_entries.front().region);
+            heatmap_entries.pop_front();
+        }
+
+        OpenGL::render_begin(fb);
+        wf::region_t faded;
+        for (auto& entry : heatmap_entries)
+        {
+            double age = std::chrono::duration<double>(now - entry.time) /
+                duration;
+            wf::color_t color{0.3 * (1 - age), 0.0, 0.0, 0.3 * (1 - age)};
+            for (const auto& rect : damage & entry.region)
+            {
+                auto box = wlr_box_from_pixman_box(rect);
+                fb.logic_scissor(box);
+                OpenGL::render_rectangle(box, color,
+                    fb.get_orthographic_projection());
+            }
+
+            faded |= entry.region;
+        }
+
+        OpenGL::render_end();
+
+        /* Keep repainting the heatmap until it fades out */
+        if (!faded.empty())
+        {
+            damage_own(faded);
+        }
+    }
+
+    void render_panel(const wf::framebuffer_t& fb, const wf::region_t& damage)
+    {
+        auto geometry = get_panel_geometry();
+        OpenGL::render_begin(fb);
+        for (const auto& rect : damage & geometry)
+        {
+            fb.logic_scissor(wlr_box_from_pixman_box(rect));
+            OpenGL::render_texture(panel.tex, fb, geometry, {1, 1, 1, 1},
+                OpenGL::TEXTURE_TRANSFORM_INVERT_Y);
+        }
+
+        OpenGL::render_end();
+    }
+
+    /** Count the views on the output which have transformers */
+    int count_transformed_views()
+    {
+        int count = 0;
+        for (auto& view : output->workspace->get_views_in_layer(wf::ALL_LAYERS))
+        {
+            view->for_each_view([&] (wayfire_view v)
+            {
+                count += v->has_transformer() ? 1 : 0;
+
+                return true;
+            });
+        }
+
+        return count;
+    }
+
+    std::vector<std::string> get_panel_lines()
+    {
+        auto& frames = output->render->get_frame_stats();
+        auto& present_interval = frames.present_interval;
+        auto& repaint_latency  = frames.repaint_latency;
+        auto& counters = OpenGL::get_render_counters();
+        int64_t output_area =
+            int64_t(output->handle->width) * output->handle->height;
+
+        std::vector<std::string> lines;
+        std::ostringstream line;
+        auto add_line = [&] ()
+        {
+            lines.push_back(line.str());
+            line.str("");
+        };
+
+        line << "CPU " << format_msec(latest.paint_usec) << " ms  GPU ";
+        if (latest.gpu_usec >= 0)
+        {
+            line << format_msec(latest.gpu_usec) << " ms";
+        } else
+        {
+            line << "n/a";
+        }
+
+        add_line();
+        line << "Present " << format_msec(present_interval.mean()) <<
+            " ms  p99 " << format_msec(present_interval.percentile(0.99)) <<
+            "  missed " << frames.missed_frames;
+        add_line();
+        line << "Repaint->present p50 " <<
+            format_msec(repaint_latency.percentile(0.5)) << " p99 " <<
+            format_msec(repaint_latency.percentile(0.99));
+        add_line();
+        line << "Input->present kbd " <<
+            format_msec(frames.keyboard_latency.percentile(0.5)) << " ptr " <<
+            format_msec(frames.pointer_latency.percentile(0.5)) << " (p50)";
+        add_line();
+        line << "Damage " << latest_damage_area << " px (" <<
+            (output_area ? 100 * latest_damage_area / output_area : 0) << "%)";
+        add_line();
+        line << "Draw calls " << latest.draw_calls << "  passes " <<
+            latest.render_passes << "  transformers " <<
+            count_transformed_views();
+        add_line();
+        line << "FB memory " << std::fixed << std::setprecision(1) <<
+            counters.framebuffer_memory / (1024.0 * 1024.0) << " MiB";
+        add_line();
+
+        static const char *stage_names[] = {
+            "pre", "damage", "render", "overlay", "postfx", "post"
+        };
+        line << "Hooks us:";
+        for (int i = 0; i < wf::FRAME_STAGE_TOTAL; i++)
+        {
+            line << " " << stage_names[i] << " " << latest.stage_usec[i];
+            if (i == wf::FRAME_STAGE_RENDER)
+            {
+                add_line();
+                line << "        ";
+            }
+        }
+
+        add_line();
+
+        return lines;
+    }
+
+    /** Draw a graph of samples in the given box */
+    void draw_graph(cairo_t *cr, wf::geometry_t box,
+        const std::deque<int64_t>& samples, int64_t reference,
+        const wf::color_t& color)
+    {
+        cairo_set_source_rgba(cr, 1, 1, 1, 0.1);
+        cairo_rectangle(cr, box.x, box.y, box.width, box.height);
+        cairo_fill(cr);
+
+        int64_t max_value = std::max<int64_t>(reference * 2, 1);
+        for (auto sample : samples)
+        {
+            max_value = std::max(max_value, sample);
+        }
+
+        auto y_for = [&] (int64_t value)
+        {
+            return box.y + box.height - 1.0 * box.height * value / max_value;
+        };
+
+        if (reference > 0)
+        {
+            cairo_set_source_rgba(cr, 1, 1, 1, 0.5);
+            cairo_set_line_width(cr, 1);
+            cairo_move_to(cr, box.x, y_for(reference));
+            cairo_line_to(cr, box.x + box.width, y_for(reference));
+            cairo_stroke(cr);
+        }
+
+        /* Cairo stores pixels as BGRA, but they are uploaded as RGBA */
+        cairo_set_source_rgba(cr, color.b, color.g, color.r, color.a);
+        cairo_set_line_width(cr, 1.5);
+        double step = 1.0 * box.width / GRAPH_FRAMES;
+        double x    = box.x + box.width - step * samples.size();
+        bool first  = true;
+        for (auto sample : samples)
+        {
+            if (first)
+            {
+                cairo_move_to(cr, x, y_for(sample));
+                first = false;
+            } else
+            {
+                cairo_line_to(cr, x, y_for(sample));
+            }
+
+            x += step;
+        }
+
+        cairo_stroke(cr);
+    }
+
+    void update_panel()
+    {
+        float scale = output->handle->scale;
+        auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+            PANEL_WIDTH * scale, PANEL_HEIGHT * scale);
+        auto cr = cairo_create(surface);
+        cairo_scale(cr, scale, scale);
+
+        cairo_set_source_rgba(cr, 0, 0, 0, 0.75);
+        cairo_rectangle(cr, 0, 0, PANEL_WIDTH, PANEL_HEIGHT);
+        cairo_fill(cr);
+
+        const double font_size = 13;
+        cairo_select_font_face(cr, "monospace",
+            CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size(cr, font_size);
+        cairo_set_source_rgba(cr, 1, 1, 1, 1);
+
+        double y = 8 + font_size;
+        for (auto& text : get_panel_lines())
+        {
+            cairo_move_to(cr, 8, y);
+            cairo_show_text(cr, text.c_str());
+            y += font_size + 4;
+        }
+
+        /* Frame times, with the refresh interval as a reference line */
+        auto& frames = output->render->get_frame_stats();
+        std::deque<int64_t> intervals;
+        frames.present_interval.for_each_sample([&] (int64_t sample)
+        {
+            push_sample(intervals, sample);
+        });
+
+        const int graph_height = 40;
+        wf::geometry_t graph = {8, (int)y, PANEL_WIDTH - 16, graph_height};
+        draw_graph(cr, graph, cpu_samples, frames.refresh_usec, {0.3, 1, 0.3, 1});
+        draw_graph(cr, graph, gpu_samples, frames.refresh_usec, {1, 0.6, 0.2, 1});
+        graph.y += graph_height + 6;
+        draw_graph(cr, graph, intervals, frames.refresh_usec, {0.4, 0.7, 1, 1});
+
+        cairo_destroy(cr);
+        OpenGL::render_begin();
+        cairo_surface_upload_to_texture(surface, panel);
+        OpenGL::render_end();
+        cairo_surface_destroy(surface);
+    }
+
+    void fini() override
+    {
+        set_active(false);
+        output->rem_binding(&toggle_cb);
+        output->rem_binding(&toggle_heatmap_cb);
+    }
+};
+
+DECLARE_WAYFIRE_PLUGIN(wayfire_hud);
@@ -663,7 +663,11 @@ class wayfire_scale : public wf::plugin_interface_t
         }
     }
 
-    /* Assign the transformer values to the view transformers */
+    /* Assign the transformer values to the view transformers.
+     *
+     * Only views whose transform actually changed are damaged, once with the
+     * old and once with the new transformed bounding box, so that a static
+     * scale layout repaints only where client contents change. */
     void transform_views()
     {
         for (auto& e : scale_data)
@@ -675,20 +679,30 @@ class wayfire_scale : public wf::plugin_interface_t
                 continue;
             }
 
+            auto& animation = view_data.animation.scale_animation;
+            auto tr = view_data.transformer;
+
+            float scale_x = animation.scale_x;
+            float scale_y = animation.scale_y;
+            float translation_x = animation.translation_x;
+            float translation_y = animation.translation_y;
+            float alpha = view_data.fade_animation;
+
+            if ((tr->scale_x == scale_x) && (tr->scale_y == scale_y) &&
+                (tr->translation_x == translation_x) &&
+                (tr->translation_y == translation_y) && (tr->alpha == alpha))
+            {
+                continue;
+            }
+
             view->damage();
-            view_data.transformer->scale_x =
-                view_data.animation.scale_animation.scale_x;
-            view_data.transformer->scale_y =
-                view_data.animation.scale_animation.scale_y;
-            view_data.transformer->translation_x =
-                view_data.animation.scale_animation.translation_x;
-            view_data.transformer->translation_y =
-                view_data.animation.scale_animation.translation_y;
-            view_data.transformer->alpha = view_data.fade_animation;
+            tr->scale_x = scale_x;
+            tr->scale_y = scale_y;
+            tr->translation_x = translation_x;
+            tr->translation_y = translation_y;
+            tr->alpha = alpha;
             view->damage();
         }
-
-        output->render->damage_whole();
     }
 
     /* Returns a list of views for all workspaces */
@@ -1137,10 +1151,10 @@ class wayfire_scale : public wf::plugin_interface_t
     /* Keep rendering until all animation has finished */
     wf::effect_hook_t post_hook = [=] ()
     {
-        output->render->schedule_redraw();
-
         if (animation_running())
         {
+            output->render->schedule_redraw();
+
             return;
         }
 
@@ -139,6 +139,7 @@ class wayfire_expo : public wf::plugin_interface_t
     {
         grab_interface->name = "expo";
         grab_interface->capabilities = wf::CAPABILITY_MANAGE_COMPOSITOR;
+        grab_interface->coalesce_pointer_motion = true;
 
         setup_workspace_bindings_from_config();
         wall = std::make_unique<wf::workspace_wall_t>(this->output);
@@ -21,7 +21,7 @@ class wayfire_grid_view_cdata : public wf::custom_data_t
 
     wayfire_view view;
     wf::output_t *output;
-    wf::effect_hook_t pre_hook;
+    wf::animation_hook_t animation_hook;
     wf::signal_callback_t unmapped;
 
     int32_t tiled_edges = -1;
@@ -49,11 +49,11 @@ class wayfire_grid_view_cdata : public wf::custom_data_t
             return;
         }
 
-        pre_hook = [=] ()
+        animation_hook = [=] ()
         {
-            adjust_geometry();
+            return adjust_geometry();
         };
-        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        output->render->add_animation(&animation_hook);
 
         unmapped = [=] (wf::signal_data_t *data)
         {
@@ -63,7 +63,6 @@ class wayfire_grid_view_cdata : public wf::custom_data_t
             }
         };
 
-        output->render->set_redraw_always(true);
         output->connect_signal("view-disappeared", &unmapped);
     }
 
@@ -127,18 +126,22 @@ class wayfire_grid_view_cdata : public wf::custom_data_t
         view->set_geometry(geometry);
     }
 
-    void adjust_geometry()
+    /** @return Whether the animation is still running */
+    bool adjust_geometry()
     {
         if (!animation.running())
         {
             set_end_state(animation, tiled_edges);
             view->set_moving(0);
             view->set_resizing(0);
+            destroy();
 
-            return destroy();
+            return false;
         }
 
         view->set_geometry((wf::geometry_t)animation);
+
+        return true;
     }
 
     ~wayfire_grid_view_cdata()
@@ -148,9 +151,8 @@ class wayfire_grid_view_cdata : public wf::custom_data_t
             return;
         }
 
-        output->render->rem_effect(&pre_hook);
+        output->render->rem_animation(&animation_hook);
         output->deactivate_plugin(iface);
-        output->render->set_redraw_always(false);
         output->disconnect_signal("view-disappeared", &unmapped);
     }
 };
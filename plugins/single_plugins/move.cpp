@@ -95,6 +95,7 @@ class wayfire_move : public wf::plugin_interface_t
         grab_interface->name = "move";
         grab_interface->capabilities =
             wf::CAPABILITY_GRAB_INPUT | wf::CAPABILITY_MANAGE_DESKTOP;
+        grab_interface->coalesce_pointer_motion = true;
 
         activate_binding = [=] (uint32_t, int, int)
         {
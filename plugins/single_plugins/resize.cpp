@@ -30,6 +30,7 @@ class wayfire_resize : public wf::plugin_interface_t
         grab_interface->name = "resize";
         grab_interface->capabilities =
             wf::CAPABILITY_GRAB_INPUT | wf::CAPABILITY_MANAGE_DESKTOP;
+        grab_interface->coalesce_pointer_motion = true;
 
         activate_binding = [=] (uint32_t, int, int)
         {
@@ -138,9 +138,46 @@ class WayfireSwitcher : public wf::plugin_interface_t
         return handle_switch_request(1);
     };
 
+    /* Whether the last repainted frame was part of an animation. We need to
+     * repaint once more after the animation ends, so that the final state of
+     * the views is shown. */
+    bool was_animating = false;
+    bool needs_repaint = false;
+
+    bool animation_running()
+    {
+        return duration.running() || background_dim_duration.running();
+    }
+
+    /* Request a full repaint for the next frame, for ex. when the view list
+     * changes outside of an animation. */
+    void schedule_repaint()
+    {
+        needs_repaint = true;
+        output->render->schedule_redraw();
+    }
+
+    /* The switcher renderer draws the whole output, so while animating we
+     * damage everything. Once the animation is done, we stop damaging and
+     * scheduling frames, so that only client updates cause a repaint. */
     wf::effect_hook_t damage = [=] ()
     {
-        output->render->damage_whole();
+        bool animating = animation_running();
+        if (animating || was_animating || needs_repaint)
+        {
+            output->render->damage_whole();
+        }
+
+        was_animating = animating;
+        needs_repaint = false;
+    };
+
+    wf::effect_hook_t post_frame = [=] ()
+    {
+        if (was_animating)
+        {
+            output->render->schedule_redraw();
+        }
     };
 
     wf::signal_callback_t view_removed = [=] (wf::signal_data_t *data)
@@ -175,6 +212,7 @@ class WayfireSwitcher : public wf::plugin_interface_t
         {
             cleanup_views([=] (SwitcherView& sv)
             { return sv.view == view; });
+            schedule_repaint();
         }
     }
 
@@ -232,8 +270,9 @@ class WayfireSwitcher : public wf::plugin_interface_t
         }
 
         output->render->add_effect(&damage, wf::OUTPUT_EFFECT_PRE);
+        output->render->add_effect(&post_frame, wf::OUTPUT_EFFECT_POST);
         output->render->set_renderer(switcher_renderer);
-        output->render->set_redraw_always();
+        schedule_repaint();
 
         return true;
     }
@@ -244,8 +283,9 @@ class WayfireSwitcher : public wf::plugin_interface_t
         output->deactivate_plugin(grab_interface);
 
         output->render->rem_effect(&damage);
+        output->render->rem_effect(&post_frame);
         output->render->set_renderer(nullptr);
-        output->render->set_redraw_always(false);
+        was_animating = needs_repaint = false;
 
         for (auto& view : output->workspace->get_views_in_layer(wf::ALL_LAYERS))
         {
@@ -428,6 +468,7 @@ class WayfireSwitcher : public wf::plugin_interface_t
         duration.start();
         background_dim.set(1, background_dim_factor);
         background_dim_duration.start();
+        schedule_repaint();
 
         auto ws_views = get_workspace_views();
         for (auto v : ws_views)
@@ -491,6 +532,7 @@ class WayfireSwitcher : public wf::plugin_interface_t
         background_dim.restart_with_end(1);
         background_dim_duration.start();
         duration.start();
+        schedule_repaint();
         active = false;
 
         /* Potentially restore view[0] if it was maximized */
@@ -714,6 +756,7 @@ class WayfireSwitcher : public wf::plugin_interface_t
         rebuild_view_list();
         output->workspace->bring_to_front(views.front().view);
         duration.start();
+        schedule_repaint();
     }
 
     int count_different_active_views()
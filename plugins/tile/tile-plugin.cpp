@@ -338,6 +338,11 @@ class tile_plugin_t : public wf::plugin_interface_t
     {
         /* Set fullscreen, and trigger resizing of the views */
         view->set_fullscreen(fullscreen);
+        if (auto node = tile::view_node_t::get_node(view))
+        {
+            node->mark_dirty();
+        }
+
         update_root_size(output->workspace->get_workarea());
     }
 
@@ -595,6 +600,7 @@ class tile_plugin_t : public wf::plugin_interface_t
         output->disconnect_signal("view-change-viewport",
             &on_view_change_viewport);
         output->disconnect_signal("view-minimize-request", &on_view_minimized);
+        tile::commit_layout_transaction(output);
     }
 };
 }
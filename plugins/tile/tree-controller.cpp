@@ -6,6 +6,7 @@
 #include <wayfire/output.hpp>
 #include <wayfire/workspace-manager.hpp>
 #include <wayfire/util.hpp>
+#include <wayfire/signal-definitions.hpp>
 #include <wayfire/nonstd/reverse.hpp>
 #include <wayfire/plugins/common/preview-indication.hpp>
 
@@ -14,7 +15,7 @@ namespace wf
 namespace tile
 {
 void for_each_view(nonstd::observer_ptr<tree_node_t> root,
-    std::function<void(wayfire_view)> callback)
+    wf::function_ref<void(wayfire_view)> callback)
 {
     if (root->as_view_node())
     {
@@ -371,10 +372,50 @@ resize_view_controller_t::resize_view_controller_t(
         horizontal_pair = this->find_resizing_pair(true);
         vertical_pair   = this->find_resizing_pair(false);
     }
+
+    on_view_unmapped.set_callback([=] (wf::signal_data_t *data)
+    {
+        auto view = wf::get_signaled_view(data);
+        auto it   = std::find(resizing_views.begin(), resizing_views.end(), view);
+        if (it != resizing_views.end())
+        {
+            view->set_resizing(false);
+            resizing_views.erase(it);
+        }
+
+        view->disconnect_signal(&on_view_unmapped);
+    });
+
+    /* Mark the views as resizing, so that core paces their configures */
+    for (auto node : {horizontal_pair.first, horizontal_pair.second,
+                      vertical_pair.first, vertical_pair.second})
+    {
+        if (!node)
+        {
+            continue;
+        }
+
+        for_each_view(node, [&] (wayfire_view view)
+        {
+            if (std::find(resizing_views.begin(), resizing_views.end(),
+                view) == resizing_views.end())
+            {
+                view->set_resizing(true);
+                view->connect_signal("unmapped", &on_view_unmapped);
+                resizing_views.push_back(view);
+            }
+        });
+    }
 }
 
 resize_view_controller_t::~resize_view_controller_t()
-{}
+{
+    /* Including views which have left the tree during the resize */
+    for (auto& view : resizing_views)
+    {
+        view->set_resizing(false);
+    }
+}
 
 uint32_t resize_view_controller_t::calculate_resizing_edges(wf::point_t grab)
 {
@@ -3,6 +3,7 @@
 
 #include "tree.hpp"
 #include <wayfire/option-wrapper.hpp>
+#include <wayfire/nonstd/function-ref.hpp>
 
 /* Contains functions which are related to manipulating the tiling tree */
 namespace wf
@@ -14,7 +15,7 @@ namespace tile
  * Run callback for each view in the tree
  */
 void for_each_view(nonstd::observer_ptr<tree_node_t> root,
-    std::function<void(wayfire_view)> callback);
+    wf::function_ref<void(wayfire_view)> callback);
 
 enum split_insertion_t
 {
@@ -146,6 +147,13 @@ class resize_view_controller_t : public tile_controller_t
     /** The vertically-aligned pair we're resizing */
     resizing_pair_t vertical_pair;
 
+    /**
+     * The views in the resizing pairs. They may leave the tree during the
+     * resize, so they are tracked until they are unmapped.
+     */
+    std::vector<wayfire_view> resizing_views;
+    wf::signal_connection_t on_view_unmapped;
+
     /*
      * Find a resizing pair in the given direction.
      *
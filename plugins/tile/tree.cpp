@@ -16,6 +16,14 @@ void tree_node_t::set_geometry(wf::geometry_t geometry)
     this->geometry = geometry;
 }
 
+void tree_node_t::mark_dirty()
+{
+    for (tree_node_t *node = this; node; node = node->parent.get())
+    {
+        node->layout_dirty = true;
+    }
+}
+
 nonstd::observer_ptr<split_node_t> tree_node_t::as_split_node()
 {
     return nonstd::make_observer(dynamic_cast<split_node_t*>(this));
@@ -45,6 +53,39 @@ wf::geometry_t get_output_local_coordinates(wf::output_t *output, wf::geometry_t
     return g;
 }
 
+struct layout_transaction_data_t : public custom_data_t
+{
+    std::unique_ptr<wf::view_transaction_t> transaction;
+    wf::wl_idle_call idle_commit;
+};
+
+wf::view_transaction_t& get_layout_transaction(wf::output_t *output)
+{
+    auto data = output->get_data_safe<layout_transaction_data_t>();
+    if (!data->transaction)
+    {
+        data->transaction = std::make_unique<wf::view_transaction_t>();
+        data->idle_commit.run_once([data] ()
+        {
+            auto transaction = std::move(data->transaction);
+            transaction->commit();
+        });
+    }
+
+    return *data->transaction;
+}
+
+void commit_layout_transaction(wf::output_t *output)
+{
+    if (!output->has_data<layout_transaction_data_t>())
+    {
+        return;
+    }
+
+    /* Destroying the pending transaction commits it */
+    output->erase_data<layout_transaction_data_t>();
+}
+
 /* ---------------------- split_node_t implementation ----------------------- */
 wf::geometry_t split_node_t::get_child_geometry(
     int32_t child_pos, int32_t child_size)
@@ -87,6 +128,7 @@ int32_t split_node_t::calculate_splittable() const
 
 void split_node_t::recalculate_children(wf::geometry_t available)
 {
+    layout_dirty = false;
     if (this->children.empty())
     {
         return;
@@ -122,7 +164,7 @@ void split_node_t::recalculate_children(wf::geometry_t available)
         child->set_geometry(get_child_geometry(child_start, child_size));
     }
 
-    set_gaps(this->gaps);
+    update_child_gaps();
 }
 
 void split_node_t::add_child(std::unique_ptr<tree_node_t> child, int index)
@@ -192,13 +234,30 @@ std::unique_ptr<tree_node_t> split_node_t::remove_child(
 
 void split_node_t::set_geometry(wf::geometry_t geometry)
 {
+    /* The layout of the children depends only on the geometry of the node and
+     * their proportions, which have not changed either */
+    if (!layout_dirty && (geometry == this->geometry))
+    {
+        return;
+    }
+
     tree_node_t::set_geometry(geometry);
     recalculate_children(geometry);
 }
 
 void split_node_t::set_gaps(const gap_size_t& gaps)
 {
+    if (gaps == this->gaps)
+    {
+        return;
+    }
+
     this->gaps = gaps;
+    update_child_gaps();
+}
+
+void split_node_t::update_child_gaps()
+{
     for (const auto& child : this->children)
     {
         gap_size_t child_gaps = gaps;
@@ -308,6 +367,7 @@ view_node_t::view_node_t(wayfire_view view)
     this->on_geometry_changed   = [=] (wf::signal_data_t*) {update_transformer(); };
     this->on_decoration_changed = [=] (wf::signal_data_t*)
     {
+        layout_dirty = true;
         set_geometry(geometry);
     };
     view->connect_signal("geometry-changed", &on_geometry_changed);
@@ -384,8 +444,27 @@ void view_node_t::set_geometry(wf::geometry_t geometry)
         return;
     }
 
-    view->set_tiled(TILED_EDGES_ALL);
-    view->set_geometry(calculate_target_geometry());
+    /* The target is compared in the coordinates of the tree, so that switching
+     * workspaces does not cause all views to be reconfigured */
+    auto target = calculate_target_geometry();
+    auto origin = get_output_local_coordinates(view->get_output(),
+        wf::point_t{0, 0});
+    auto tree_target = target;
+    tree_target.x -= origin.x;
+    tree_target.y -= origin.y;
+    if (!layout_dirty && (tree_target == last_target))
+    {
+        return;
+    }
+
+    layout_dirty = false;
+    last_target  = tree_target;
+    if (view->tiled_edges != TILED_EDGES_ALL)
+    {
+        view->set_tiled(TILED_EDGES_ALL);
+    }
+
+    get_layout_transaction(view->get_output()).set_geometry(view, target);
 }
 
 void view_node_t::update_transformer()
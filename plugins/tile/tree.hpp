@@ -2,6 +2,7 @@
 #define WF_TILE_PLUGIN_TREE
 
 #include <wayfire/view.hpp>
+#include <wayfire/view-transaction.hpp>
 
 namespace wf
 {
@@ -30,6 +31,18 @@ struct gap_size_t
     int32_t bottom = 0;
     /* Gap for internal splits */
     int32_t internal = 0;
+
+    bool operator ==(const gap_size_t& other) const
+    {
+        return left == other.left && right == other.right &&
+               top == other.top && bottom == other.bottom &&
+               internal == other.internal;
+    }
+
+    bool operator !=(const gap_size_t& other) const
+    {
+        return !(*this == other);
+    }
 };
 
 struct tree_node_t
@@ -43,9 +56,21 @@ struct tree_node_t
     /** The geometry occupied by the node */
     wf::geometry_t geometry;
 
-    /** Set the geometry available for the node and its subnodes. */
+    /**
+     * Set the geometry available for the node and its subnodes.
+     *
+     * Subtrees whose geometry does not change are not laid out again, unless
+     * they have been marked dirty.
+     */
     virtual void set_geometry(wf::geometry_t geometry);
 
+    /**
+     * Mark the node and its ancestors as needing a relayout, for changes which
+     * do not affect the geometry of the node, for ex. a view becoming
+     * fullscreen. The next set_geometry() on the root will reach the node.
+     */
+    void mark_dirty();
+
     /** Set the gaps for the node and subnodes. */
     virtual void set_gaps(const gap_size_t& gaps) = 0;
 
@@ -60,6 +85,8 @@ struct tree_node_t
   protected:
     /* Gaps */
     gap_size_t gaps;
+    /* Whether the node has to be laid out even if its geometry is the same */
+    bool layout_dirty = true;
 };
 
 /**
@@ -119,6 +146,9 @@ struct split_node_t : public tree_node_t
      */
     void recalculate_children(wf::geometry_t available_geometry);
 
+    /** Update the gaps of the children after the list of children changed */
+    void update_child_gaps();
+
     /**
      * Calculate the geometry of a child if it has child_size as one
      * dimension. Whether this is width/height depends on the node split type.
@@ -152,6 +182,9 @@ struct view_node_t : public tree_node_t
      * Note that the resulting view geometry will not always be equal to the
      * geometry of the node. For example, a fullscreen view will always have
      * the geometry of the whole output.
+     *
+     * The view is reconfigured only if its target geometry changed, or if the
+     * node was marked dirty.
      */
     void set_geometry(wf::geometry_t geometry) override;
 
@@ -169,6 +202,9 @@ struct view_node_t : public tree_node_t
     nonstd::observer_ptr<scale_transformer_t> transformer;
     signal_callback_t on_geometry_changed, on_decoration_changed;
 
+    /* The geometry last requested for the view, in tree coordinates */
+    wf::geometry_t last_target = {0, 0, 0, 0};
+
     wf::geometry_t calculate_target_geometry();
     void update_transformer();
 };
@@ -189,6 +225,19 @@ void flatten_tree(std::unique_ptr<tree_node_t>& root);
  */
 nonstd::observer_ptr<split_node_t> get_root(nonstd::observer_ptr<tree_node_t> node);
 
+/**
+ * Get the transaction which collects the geometry changes of tiled views on
+ * the output. It is committed automatically when the event loop goes idle,
+ * so that a relayout of the tree is presented in a single frame.
+ */
+wf::view_transaction_t& get_layout_transaction(wf::output_t *output);
+
+/**
+ * Commit the pending layout transaction of the output, if there is one, and
+ * release the data associated with it.
+ */
+void commit_layout_transaction(wf::output_t *output);
+
 /**
  * Transform coordinates from the tiling trees coordinate system to output-local
  * coordinates.
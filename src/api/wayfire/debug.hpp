@@ -7,6 +7,74 @@
 
 #define nonull(x) ((x) ? (x) : ("nil"))
 #include <wayfire/util/log.hpp>
+#include <bitset>
+#include <cstdint>
+
+namespace wf
+{
+namespace log
+{
+/**
+ * Subsystems which can have their debug messages enabled separately.
+ */
+enum class logging_category : size_t
+{
+    // Messages from wlroots
+    WLR     = 0,
+    // Mapping, geometry and state changes of views
+    VIEWS   = 1,
+    // Input devices and input events
+    INPUT   = 2,
+    // Output configuration and rendering
+    RENDER  = 3,
+    // Xwayland and its views
+    XWL     = 4,
+    // Loading and running plugins
+    PLUGINS = 5,
+    TOTAL,
+};
+
+/**
+ * The categories which are enabled at runtime, set from the command line.
+ * By default, all categories are enabled when running with --debug.
+ */
+extern std::bitset<(size_t)logging_category::TOTAL> enabled_categories;
+
+/**
+ * Parse a comma-separated list of category names (case-insensitive), or
+ * "all" for all categories.
+ *
+ * @return true on success, false if an unknown category was given.
+ */
+bool parse_categories(const std::string& list,
+    std::bitset<(size_t)logging_category::TOTAL>& result);
+}
+}
+
+/**
+ * A bitmask of the categories whose messages are compiled in at all.
+ * Define it (for ex. to 0) before including this header to strip the
+ * LOGC() calls of some categories at compile time.
+ */
+#ifndef WF_LOG_COMPILED_CATEGORIES
+    #define WF_LOG_COMPILED_CATEGORIES (~(uint64_t)0)
+#endif
+
+/**
+ * Log a debug message in the given category, for ex. LOGC(VIEWS, "map ", view).
+ *
+ * The arguments are evaluated and formatted only if the category is enabled,
+ * so LOGC() calls are cheap enough for hot paths.
+ */
+#define LOGC(CAT, ...) \
+    do { \
+        if ((WF_LOG_COMPILED_CATEGORIES & \
+             ((uint64_t)1 << (size_t)wf::log::logging_category::CAT)) && \
+            wf::log::enabled_categories[(size_t)wf::log::logging_category::CAT]) \
+        { \
+            LOGD("[", #CAT, "] ", __VA_ARGS__); \
+        } \
+    } while (0)
 
 namespace wf
 {
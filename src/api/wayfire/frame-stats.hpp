@@ -0,0 +1,155 @@
+#ifndef WF_FRAME_STATS_HPP
+#define WF_FRAME_STATS_HPP
+
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <wayfire/object.hpp>
+#include <wayfire/nonstd/function-ref.hpp>
+
+namespace wf
+{
+class output_t;
+
+/**
+ * A histogram of the most recent samples of a duration.
+ *
+ * The histogram keeps only the last WINDOW samples, so that it reflects the
+ * current behavior of the compositor rather than its whole lifetime. All
+ * durations are in microseconds.
+ */
+class frame_histogram_t
+{
+  public:
+    /** Number of samples kept */
+    static constexpr size_t WINDOW = 512;
+    /** Width of each bucket */
+    static constexpr int64_t BUCKET_USEC = 250;
+    /** Number of buckets, the last one also holds all larger samples */
+    static constexpr size_t NUM_BUCKETS = 400;
+
+    /** Add a new sample, evicting the oldest one if the window is full. */
+    void add_sample(int64_t usec);
+
+    /** @return The number of samples in the window. */
+    size_t size() const;
+
+    /** @return The latest sample, or 0 if there are no samples. */
+    int64_t last() const;
+    /** @return The average of the samples in the window. */
+    int64_t mean() const;
+    /** @return The largest sample in the window. */
+    int64_t max() const;
+
+    /**
+     * Estimate a percentile of the samples in the window.
+     *
+     * @param p The percentile, in the range [0, 1].
+     * @return The upper bound of the bucket containing the percentile.
+     */
+    int64_t percentile(double p) const;
+
+    /** Call func for each sample in the window, oldest first. */
+    void for_each_sample(wf::function_ref<void(int64_t)> func) const;
+
+    /** @return The number of samples in each bucket. */
+    const std::array<uint32_t, NUM_BUCKETS>& get_buckets() const;
+
+  private:
+    std::array<int64_t, WINDOW> samples;
+    std::array<uint32_t, NUM_BUCKETS> buckets = {};
+    size_t next  = 0;
+    size_t count = 0;
+    int64_t sum  = 0;
+};
+
+/**
+ * Frame pacing and latency statistics of an output, collected from the
+ * presentation feedback of the output.
+ */
+struct frame_stats_t
+{
+    /** Time between consecutive presented frames */
+    frame_histogram_t present_interval;
+    /** Time from the start of a repaint until the frame is presented */
+    frame_histogram_t repaint_latency;
+    /**
+     * Time from the latest keyboard/pointer event handled before a repaint
+     * until the frame is presented. Input timestamps have a resolution of
+     * 1ms, and are available only if the backend uses CLOCK_MONOTONIC.
+     */
+    frame_histogram_t keyboard_latency;
+    frame_histogram_t pointer_latency;
+
+    /** Number of presented frames */
+    uint64_t frames_presented = 0;
+    /** Number of vblanks by which frames missed their expected vblank */
+    uint64_t missed_frames = 0;
+    /** The refresh interval of the output, or 0 if unknown */
+    int64_t refresh_usec = 0;
+};
+
+/** The parts of a repaint which are timed by the render manager */
+enum frame_stage_t
+{
+    /** OUTPUT_EFFECT_PRE hooks */
+    FRAME_STAGE_PRE         = 0,
+    /** OUTPUT_EFFECT_DAMAGE hooks */
+    FRAME_STAGE_DAMAGE      = 1,
+    /** The default renderer or the render hook of a plugin */
+    FRAME_STAGE_RENDER      = 2,
+    /** OUTPUT_EFFECT_OVERLAY hooks and software cursors */
+    FRAME_STAGE_OVERLAY     = 3,
+    /** Postprocessing effects */
+    FRAME_STAGE_POSTPROCESS = 4,
+    /** OUTPUT_EFFECT_POST hooks */
+    FRAME_STAGE_POST        = 5,
+    FRAME_STAGE_TOTAL       = 6,
+};
+
+/**
+ * The work done by the render manager for the last repainted frame of an
+ * output.
+ */
+struct frame_render_stats_t
+{
+    /** CPU time spent in each stage */
+    std::array<int64_t, FRAME_STAGE_TOTAL> stage_usec = {};
+    /** CPU time of the whole repaint */
+    int64_t paint_usec = 0;
+    /**
+     * GPU time of the render and postprocess stages, or -1 if the driver does
+     * not support timer queries. GPU results arrive a few frames late, so this
+     * is the latest measurement rather than the one for this frame.
+     */
+    int64_t gpu_usec = -1;
+    /** Draw calls issued during the repaint */
+    uint64_t draw_calls = 0;
+    /** Rendering passes during the repaint, see OpenGL::render_counters_t */
+    uint64_t render_passes = 0;
+    /** The area of the repainted region, in output pixels */
+    int64_t damage_area = 0;
+};
+
+/**
+ * name: frame-presented
+ * on: render-manager
+ * when: After a frame rendered by the render manager has been presented.
+ */
+struct frame_presented_signal : public wf::signal_data_t
+{
+    wf::output_t *output;
+    /** When the frame was presented, on the backend's presentation clock */
+    timespec when;
+    /** Time since the previous presented frame, or -1 if unknown */
+    int64_t interval_usec = -1;
+    /** Time from the start of the repaint to presentation */
+    int64_t repaint_latency_usec = -1;
+    /** Number of vblanks the frame missed */
+    int missed_frames = 0;
+    /** The accumulated statistics of the output */
+    const frame_stats_t *stats;
+};
+}
+
+#endif /* end of include guard: WF_FRAME_STATS_HPP */
@@ -0,0 +1,45 @@
+#ifndef WF_FUNCTION_REF_HPP
+#define WF_FUNCTION_REF_HPP
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace wf
+{
+template<class Signature>
+class function_ref;
+
+/**
+ * A non-owning reference to a callable object.
+ *
+ * Unlike std::function, it never allocates, so it is suitable for callbacks
+ * on hot paths. The referenced callable must outlive the function_ref, which
+ * is why it should be used only for function parameters.
+ */
+template<class R, class... Args>
+class function_ref<R(Args...)>
+{
+  public:
+    template<class F, class = std::enable_if_t<
+        !std::is_same_v<std::decay_t<F>, function_ref>>>
+    function_ref(F&& f) :
+        object((void*)std::addressof(f)),
+        callback([] (void *obj, Args... args) -> R
+    {
+        return (*(std::remove_reference_t<F>*)obj)(std::forward<Args>(args)...);
+    })
+    {}
+
+    R operator ()(Args... args) const
+    {
+        return callback(object, std::forward<Args>(args)...);
+    }
+
+  private:
+    void *object;
+    R (*callback)(void*, Args...);
+};
+}
+
+#endif /* end of include guard: WF_FUNCTION_REF_HPP */
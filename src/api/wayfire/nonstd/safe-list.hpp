@@ -1,68 +1,158 @@
 #ifndef WF_SAFE_LIST_HPP
 #define WF_SAFE_LIST_HPP
 
-#include <list>
-#include <memory>
+#include <deque>
+#include <vector>
+#include <optional>
 #include <algorithm>
 #include <functional>
+#include <stdexcept>
 
-#include <wayland-server.h>
-
+#include "function-ref.hpp"
 #include "reverse.hpp"
 
-/* This is a trimmed-down wrapper of std::list<T>.
+/* This is a trimmed-down list container, backed by a std::vector.
  *
  * It supports safe iteration over all elements in the collection, where any
  * element can be deleted from the list at any given time (i.e even in a
- * for-each-like loop) */
+ * for-each-like loop).
+ *
+ * While the list is being iterated, erased elements are only marked as empty,
+ * and new elements are kept aside, so that the storage of the elements being
+ * iterated never changes. When the outermost iteration ends, the list is
+ * compacted.
+ *
+ * An iteration does not visit the elements added while it runs. Iterations
+ * started in the meantime (for ex. by a signal emitted from a callback) see
+ * them in their place, like with a plain list. */
 namespace wf
 {
-/* The object type depends on the safe list type, and the safe list type
- * needs access to the event loop. However, the event loop is typically
- * available from core.hpp. Because we can't resolve this circular dependency,
- * we provide a link to the event loop specially for the safe list */
-namespace _safe_list_detail
-{
-/* In main.cpp, and initialized there */
-extern wl_event_loop *event_loop;
-void idle_cleanup_func(void *data);
-}
-
 template<class T>
 class safe_list_t
 {
-    std::list<std::unique_ptr<T>> list;
-    wl_event_source *idle_cleanup_source = NULL;
-
-    /* Remove all invalidated elements in the list */
-    std::function<void()> do_cleanup = [&] ()
+    /* Iteration is const, but it compacts the list at the end, hence all the
+     * storage is mutable */
+    mutable std::vector<std::optional<T>> list;
+
+    /* Elements added during iteration, together with the index in list
+     * before which they should be inserted. Erased ones are marked as empty,
+     * and the deque keeps the others in place while more are added, because
+     * nested iterations visit them too. */
+    mutable std::deque<std::pair<size_t, std::optional<T>>> pending;
+
+    /* Number of active for_each() calls */
+    mutable int iteration_depth = 0;
+    /* Whether list has empty elements */
+    mutable bool dirty = false;
+    /* Number of non-erased elements, including pending ones */
+    size_t count = 0;
+
+    /* Remove all erased elements and insert the pending ones */
+    void compact() const
     {
-        auto it = list.begin();
-        while (it != list.end())
+        if (!dirty && pending.empty())
+        {
+            return;
+        }
+
+        std::stable_sort(pending.begin(), pending.end(),
+            [] (const auto& a, const auto& b) { return a.first < b.first; });
+
+        std::vector<std::optional<T>> result;
+        result.reserve(list.size() + pending.size());
+        auto next_pending = pending.begin();
+        for (size_t i = 0; i <= list.size(); i++)
         {
-            if (*it)
+            while (next_pending != pending.end() && next_pending->first == i)
             {
-                ++it;
-            } else
+                if (next_pending->second)
+                {
+                    result.emplace_back(std::move(next_pending->second));
+                }
+
+                ++next_pending;
+            }
+
+            if ((i < list.size()) && list[i])
             {
-                it = list.erase(it);
+                result.emplace_back(std::move(list[i]));
             }
         }
 
-        idle_cleanup_source = NULL;
+        list = std::move(result);
+        pending.clear();
+        dirty = false;
+    }
+
+    /* Mark the list as iterated for the lifetime of the guard */
+    struct iteration_guard_t
+    {
+        const safe_list_t *self;
+        iteration_guard_t(const safe_list_t *self) : self(self)
+        {
+            ++self->iteration_depth;
+        }
+
+        ~iteration_guard_t()
+        {
+            if (--self->iteration_depth == 0)
+            {
+                self->compact();
+            }
+        }
     };
 
-    /* Return whether the list has invalidated elements */
-    bool is_dirty() const
+    /* All slots of the list including the pending elements, in list order.
+     * The pointers stay valid until the outermost iteration ends. */
+    std::vector<std::optional<T>*> collect_slots() const
     {
-        return idle_cleanup_source;
+        std::vector<std::pair<size_t, std::optional<T>*>> added;
+        for (auto& el : pending)
+        {
+            added.emplace_back(el.first, &el.second);
+        }
+
+        std::stable_sort(added.begin(), added.end(),
+            [] (const auto& a, const auto& b) { return a.first < b.first; });
+
+        std::vector<std::optional<T>*> slots;
+        slots.reserve(list.size() + added.size());
+        auto next_added = added.begin();
+        for (size_t i = 0; i <= list.size(); i++)
+        {
+            while (next_added != added.end() && next_added->first == i)
+            {
+                slots.push_back(next_added->second);
+                ++next_added;
+            }
+
+            if (i < list.size())
+            {
+                slots.push_back(&list[i]);
+            }
+        }
+
+        return slots;
+    }
+
+    /* Add an element before the given index of list */
+    void insert_element(size_t index, T&& value)
+    {
+        ++count;
+        if (iteration_depth > 0)
+        {
+            pending.emplace_back(index, std::move(value));
+        } else
+        {
+            list.emplace(list.begin() + index, std::move(value));
+        }
     }
 
   public:
     safe_list_t()
     {}
 
-    /* Copy the not-erased elements from other, but do not copy the idle source */
+    /* Copy the not-erased elements from other */
     safe_list_t(const safe_list_t& other)
     {
         *this = other;
@@ -70,73 +160,91 @@ class safe_list_t
 
     safe_list_t& operator =(const safe_list_t& other)
     {
-        this->idle_cleanup_source = NULL;
-        other.for_each([&] (auto& el)
+        if (this == &other)
         {
-            this->push_back(el);
-        });
-    }
+            return *this;
+        }
 
-    safe_list_t(safe_list_t&& other) = default;
-    safe_list_t& operator =(safe_list_t&& other) = default;
+        this->list.clear();
+        this->pending.clear();
+        this->dirty = false;
+        this->count = 0;
 
-    ~safe_list_t()
-    {
-        if (idle_cleanup_source)
+        other.compact_if_idle();
+        for (auto& el : other.list)
         {
-            wl_event_source_remove(idle_cleanup_source);
+            if (el)
+            {
+                this->push_back(*el);
+            }
+        }
+
+        /* If other is being iterated, its pending elements are still apart */
+        for (auto& el : other.pending)
+        {
+            if (el.second)
+            {
+                this->push_back(*el.second);
+            }
         }
+
+        return *this;
     }
 
+    safe_list_t(safe_list_t&& other) = default;
+    safe_list_t& operator =(safe_list_t&& other) = default;
+
     T& back()
     {
-        /* No invalidated elements */
-        if (!is_dirty())
+        /* The last non-erased element in list */
+        auto it = std::find_if(list.rbegin(), list.rend(),
+            [] (const auto& el) { return el.has_value(); });
+        bool have_last = (it != list.rend());
+        size_t last_index = have_last ? list.rend() - it - 1 : 0;
+        T *result = have_last ? &**it : nullptr;
+
+        /* Pending elements inserted after it come after it */
+        size_t best_pending = 0;
+        bool pending_is_best = false;
+        for (auto& [index, value] : pending)
         {
-            return *list.back();
-        }
+            if (!value)
+            {
+                continue;
+            }
 
-        auto it = list.rbegin();
-        while (it != list.rend() && (*it) == nullptr)
-        {
-            ++it;
+            if ((pending_is_best && (index >= best_pending)) ||
+                (!pending_is_best && (!have_last || (index > last_index))))
+            {
+                result = &*value;
+                best_pending    = index;
+                pending_is_best = true;
+            }
         }
 
-        if (it == list.rend())
+        if (!result)
         {
             throw std::out_of_range("back() called on an empty list!");
         }
 
-        return **it;
+        return *result;
     }
 
     size_t size() const
     {
-        if (!is_dirty())
-        {
-            return list.size();
-        }
-
-        /* Count non-null elements, because that's the real size */
-        size_t sz = 0;
-        for (auto& it : list)
-        {
-            sz += (it != nullptr);
-        }
-
-        return sz;
+        return count;
     }
 
     /* Push back by copying */
     void push_back(T value)
     {
-        list.push_back(std::make_unique<T>(std::move(value)));
+        insert_element(list.size(), std::move(value));
     }
 
     /* Push back by moving */
     void emplace_back(T&& value)
     {
-        list.push_back(std::make_unique<T>(value));
+        insert_element(list.size(), std::move(value));
     }
 
     enum insert_place_t
@@ -151,35 +259,25 @@ class safe_list_t
      * check indicates, or at the end of the list otherwise */
     void emplace_at(T&& value, std::function<insert_place_t(T&)> check)
     {
-        auto it = list.begin();
-        while (it != list.end())
+        for (size_t i = 0; i < list.size(); i++)
         {
             /* Skip empty elements */
-            if (*it == nullptr)
+            if (!list[i])
             {
-                ++it;
                 continue;
             }
 
-            auto place = check(**it);
-            switch (place)
+            switch (check(*list[i]))
             {
               case INSERT_AFTER:
-                /* We can safely increment it, because it points to an
-                 * element in the list */
-                ++it;
+                return insert_element(i + 1, std::move(value));
 
-              // fall through
               case INSERT_BEFORE:
-                list.emplace(it, std::make_unique<T>(value));
-
-                return;
+                return insert_element(i, std::move(value));
 
               default:
                 break;
             }
-
-            ++it;
         }
 
         /* If no place found, insert at the end */
@@ -192,28 +290,61 @@ class safe_list_t
     }
 
     /* Call func for each non-erased element of the list */
-    void for_each(std::function<void(T&)> func) const
+    void for_each(wf::function_ref<void(T&)> func) const
     {
-        /* Go through all elements currently in the list */
-        auto it = list.begin();
-        for (int size = list.size(); size > 0; size--, it++)
+        iteration_guard_t guard{this};
+
+        /* Nested in an iteration which has added elements */
+        if (!pending.empty())
+        {
+            for (auto slot : collect_slots())
+            {
+                if (*slot)
+                {
+                    func(**slot);
+                }
+            }
+
+            return;
+        }
+
+        /* Go through all elements currently in the list. Elements added in
+         * the meantime are pending, so the list cannot be reallocated. */
+        const size_t size = list.size();
+        for (size_t i = 0; i < size; i++)
         {
-            if (*it)
+            if (list[i])
             {
-                func(**it);
+                func(*list[i]);
             }
         }
     }
 
     /* Call func for each non-erased element of the list in reversed order */
-    void for_each_reverse(std::function<void(T&)> func) const
+    void for_each_reverse(wf::function_ref<void(T&)> func) const
     {
-        auto it = list.rbegin();
-        for (int size = list.size(); size > 0; size--, it++)
+        iteration_guard_t guard{this};
+
+        /* Nested in an iteration which has added elements */
+        if (!pending.empty())
         {
-            if (*it)
+            auto slots = collect_slots();
+            for (auto slot : wf::reverse(slots))
             {
-                func(**it);
+                if (*slot)
+                {
+                    func(**slot);
+                }
+            }
+
+            return;
+        }
+
+        for (size_t i = list.size(); i > 0; i--)
+        {
+            if (list[i - 1])
+            {
+                func(*list[i - 1]);
             }
         }
     }
@@ -221,38 +352,54 @@ class safe_list_t
     /* Safely remove all elements equal to value */
     void remove_all(const T& value)
     {
-        remove_if([=] (const T& el) { return el == value; });
+        remove_if([&] (const T& el) { return el == value; });
     }
 
     /* Remove all elements from the list */
     void clear()
     {
-        remove_if([] (const T& el) { return true; });
+        remove_if([] (const T&) { return true; });
     }
 
     /* Remove all elements satisfying a given condition.
-     * This function resets their pointers and scheduling a cleanup operation */
-    void remove_if(std::function<bool(const T&)> predicate)
+     * The elements are destroyed only after they have been removed from the
+     * list, so their destructors see a consistent list. */
+    void remove_if(wf::function_ref<bool(const T&)> predicate)
     {
-        bool actually_removed = false;
-        for (auto& it : list)
+        std::vector<T> removed;
+        for (auto& el : list)
         {
-            if (it && predicate(*it))
+            if (el && predicate(*el))
             {
-                actually_removed = true;
-                /* First reset the element in the list, and then free resources */
-                auto copy = std::move(it);
-                it = nullptr;
-                /* Now copy goes out of scope */
+                removed.push_back(std::move(*el));
+                el.reset();
+                dirty = true;
             }
         }
 
-        /* Schedule a clean-up, but be careful to not schedule it twice */
-        if (!idle_cleanup_source && actually_removed)
+        /* Pending elements may be visited by nested iterations, so they
+         * are only marked as empty too */
+        for (auto& el : pending)
+        {
+            if (el.second && predicate(*el.second))
+            {
+                removed.push_back(std::move(*el.second));
+                el.second.reset();
+                dirty = true;
+            }
+        }
+
+        count -= removed.size();
+        compact_if_idle();
+        /* Now removed goes out of scope */
+    }
+
+  private:
+    void compact_if_idle() const
+    {
+        if (iteration_depth == 0)
         {
-            idle_cleanup_source = wl_event_loop_add_idle(
-                _safe_list_detail::event_loop,
-                _safe_list_detail::idle_cleanup_func, &do_cleanup);
+            compact();
         }
     }
 };
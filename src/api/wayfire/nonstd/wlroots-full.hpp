@@ -76,6 +76,8 @@ extern "C"
 #if WLR_HAS_X11_BACKEND
     #include <wlr/backend/x11.h>
 #endif
+#include <wlr/backend/headless.h>
+#include <wlr/backend/multi.h>
 #include <wlr/backend/noop.h>
 #include <wlr/backend/wayland.h>
 #undef static
@@ -99,6 +101,8 @@ extern "C"
     #include <wlr/types/wlr_pointer_constraints_v1.h>
 #endif
 #include <wlr/types/wlr_cursor.h>
+#include <wlr/types/wlr_pointer.h>
+#include <wlr/types/wlr_touch.h>
 #if __has_include(<tablet-unstable-v2-protocol.h>)
     #include <wlr/types/wlr_tablet_v2.h>
 #endif
@@ -175,6 +175,24 @@ void render_begin(int32_t viewport_width, int32_t viewport_height, uint32_t fb);
  * render_end() must be called for each render_begin() */
 void render_end();
 
+/**
+ * Counters of the rendering work done since the compositor started, for
+ * performance monitoring. The work done between two points in time is the
+ * difference of the counters at these points.
+ */
+struct render_counters_t
+{
+    /** Draw calls issued with GL_CALL */
+    uint64_t draw_calls = 0;
+    /** Calls to render_begin() with a target framebuffer */
+    uint64_t render_passes = 0;
+    /** Memory used by the textures of framebuffer_base_t, in bytes */
+    int64_t framebuffer_memory = 0;
+};
+
+/** @return The current values of the rendering counters. */
+const render_counters_t& get_render_counters();
+
 /* Clear the currently bound framebuffer with the given color */
 void clear(wf::color_t color, uint32_t mask = GL_COLOR_BUFFER_BIT);
 
@@ -187,6 +205,9 @@ enum texture_rendering_flags_t
     TEXTURE_TRANSFORM_INVERT_Y = (1 << 1),
     /* Use a subrectangle of the texture to render */
     TEXTURE_USE_TEX_GEOMETRY   = (1 << 2),
+    /* The texture is opaque in the rendered area, so it can be drawn without
+     * blending. Ignored if the color multiplier is translucent. */
+    TEXTURE_OPAQUE = (1 << 3),
 };
 
 /**
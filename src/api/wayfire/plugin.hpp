@@ -67,6 +67,18 @@ struct plugin_grab_interface_t
     /** Ungrab input, if it is grabbed. */
     void ungrab();
 
+    /**
+     * When set, pointer motion is coalesced while the input is grabbed:
+     * callbacks.pointer.motion is called at most once per frame of the grab's
+     * output, right before the frame is painted, with the latest cursor
+     * position. Pending motion is also delivered before button events.
+     *
+     * callbacks.pointer.relative_motion is still called for every event, so
+     * plugins which need the raw deltas (for ex. to compute velocity) can use
+     * it.
+     */
+    bool coalesce_pointer_motion = false;
+
     /**
      * When grabbed, core will redirect all input events to the grabbing plugin.
      * The grabbing plugin can subscribe to different input events by setting
@@ -167,7 +179,7 @@ class plugin_interface_t
 using wayfire_plugin_load_func = wf::plugin_interface_t * (*)();
 
 /** The version of Wayfire's API/ABI */
-constexpr uint32_t WAYFIRE_API_ABI_VERSION = 2020'10'22;
+constexpr uint32_t WAYFIRE_API_ABI_VERSION = 2026'10'18;
 
 /**
  * Each plugin must also provide a function which returns the Wayfire API/ABI
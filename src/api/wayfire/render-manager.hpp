@@ -8,8 +8,11 @@ namespace wf
 {
 struct framebuffer_base_t;
 struct framebuffer_t;
+class surface_interface_t;
 struct region_t;
 struct workspace_stream_t;
+struct frame_stats_t;
+struct frame_render_stats_t;
 /** Render hooks can be used to override Wayfire's built-in rendering. The
  * plugin which sets the hook gains full control over what and how is drawn
  * to the screen. Workspace streams however are not affected.
@@ -21,6 +24,15 @@ using render_hook_t = std::function<void (const wf::framebuffer_t& fb)>;
  * at certain parts of the repaint cycle */
 using effect_hook_t = std::function<void ()>;
 
+/**
+ * An animation driven by the output's frame cycle, see
+ * render_manager::add_animation().
+ *
+ * @return Whether the animation is still running. Finished animations are
+ *   removed automatically.
+ */
+using animation_hook_t = std::function<bool ()>;
+
 enum output_effect_type_t
 {
     /* Pre hooks are called before starting to repaint the output */
@@ -94,6 +106,14 @@ class render_manager : public wf::signal_provider_t
      */
     void schedule_redraw();
 
+    /**
+     * Schedule a frame event for a surface which has committed new contents.
+     * If the surface is visible on the output, a frame is scheduled like with
+     * schedule_redraw(). Otherwise, the output is not repainted, and frame
+     * events are sent to hidden surfaces from a low-rate timer instead.
+     */
+    void schedule_surface_frame(wf::surface_interface_t *surface);
+
     /**
      * Inhibit rendering to the output. An inhibited output will show a
      * fully black image. Used mainly for compositor fade in/out on startup.
@@ -112,6 +132,25 @@ class render_manager : public wf::signal_provider_t
      */
     void rem_effect(effect_hook_t *hook);
 
+    /**
+     * Add an animation to the output's timeline.
+     *
+     * All animations of an output are stepped together, once per frame,
+     * right before the pre-paint effect hooks. While at least one animation
+     * is running, the output keeps scheduling frames, so animations do not
+     * need to schedule redraws or set redraw_always themselves. Once all of
+     * them have finished, no more frames are scheduled on their behalf.
+     *
+     * @param hook The animation callback. It must stay valid until the
+     *   animation finishes or is removed.
+     */
+    void add_animation(animation_hook_t *hook);
+
+    /**
+     * Remove an animation from the timeline. No-op if it isn't running.
+     */
+    void rem_animation(animation_hook_t *hook);
+
     /**
      * Add a new post hook.
      *
@@ -181,10 +220,26 @@ class render_manager : public wf::signal_provider_t
      */
     wf::framebuffer_t get_target_framebuffer() const;
 
+    /**
+     * @return The frame pacing and latency statistics of the output. They are
+     * updated whenever a frame is presented, right before the frame-presented
+     * signal is emitted.
+     */
+    const wf::frame_stats_t& get_frame_stats() const;
+
+    /**
+     * @return The work done for the last frame which was repainted and
+     * committed. The statistics are updated at the end of each such repaint.
+     */
+    const wf::frame_render_stats_t& get_render_stats() const;
+
     /**
      * Initialize a workspace stream. If you need to change the stream's
      * attributes, you should stop the stream, and start it again
      *
+     * The stream is first rendered with the scale set in stream.scale_x and
+     * stream.scale_y.
+     *
      * @param stream The stream to be initialized
      */
     void workspace_stream_start(workspace_stream_t& stream);
@@ -194,9 +249,16 @@ class render_manager : public wf::signal_provider_t
      * This function should be called inside the rendering cycle, i.e in a
      * render or an overlay hook.
      *
+     * The stream is rendered at a fraction of the output resolution, which
+     * saves a lot of work when the stream is shown scaled down anyway. Changing
+     * the scale causes a full repaint of the stream. Streams are always scaled
+     * uniformly, by the larger of the two factors, and never above 1.
+     *
      * @param stream The workspace stream to update
-     * @param scale_x Unused for now
-     * @param scale_y Unused for now
+     * @param scale_x The horizontal scale of the stream buffer, relative to the
+     *   output resolution.
+     * @param scale_y The vertical scale of the stream buffer, relative to the
+     *   output resolution.
      */
     void workspace_stream_update(workspace_stream_t& stream,
         float scale_x = 1, float scale_y = 1);
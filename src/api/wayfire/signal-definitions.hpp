@@ -3,6 +3,7 @@
 
 #include "wayfire/view.hpp"
 #include "wayfire/output.hpp"
+#include <set>
 
 /**
  * Documentation of signals emitted from core components.
@@ -30,6 +31,39 @@ namespace wf
  * argument: unused
  */
 
+/**
+ * name: reload-config
+ * on: core
+ * when: After the config file has been reloaded, if at least one option has
+ *   changed. The signal may also be emitted with NULL data, in which case
+ *   all options should be considered changed.
+ */
+struct reload_config_signal : public wf::signal_data_t
+{
+    /** The full names (section/option) of the changed options */
+    std::set<std::string> changed_options;
+    /** The sections which have changed options, or which were added/removed */
+    std::set<std::string> changed_sections;
+
+    bool option_changed(const std::string& name) const
+    {
+        return changed_options.count(name);
+    }
+
+    bool section_changed(const std::string& section) const
+    {
+        return changed_sections.count(section);
+    }
+
+    /** @return true if any section whose name starts with prefix changed */
+    bool section_prefix_changed(const std::string& prefix) const
+    {
+        auto it = changed_sections.lower_bound(prefix);
+        return it != changed_sections.end() &&
+               it->compare(0, prefix.size(), prefix) == 0;
+    }
+};
+
 class input_device_t;
 /**
  * name: input-device-added, input-device-removed
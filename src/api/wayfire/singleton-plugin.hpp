@@ -23,7 +23,7 @@ struct singleton_data_t : public custom_data_t
     }
 
   private:
-    int rcnt;
+    int rcnt = 0;
 };
 }
 
@@ -8,6 +8,7 @@
 
 #include <wayfire/nonstd/wlroots.hpp>
 #include <wayfire/nonstd/observer_ptr.h>
+#include <wayfire/nonstd/function-ref.hpp>
 #include <wayfire/geometry.hpp>
 
 namespace wf
@@ -87,9 +88,35 @@ class surface_interface_t
      * @return a list of each mapped surface in the surface tree, including the
      * surface itself.
      *
-     * The surfaces should be ordered from the topmost to the bottom-most one.
+     * The surfaces are ordered from the topmost to the bottom-most one. This
+     * is a convenience wrapper around for_each_surface(), which should be
+     * preferred on hot paths as it does not allocate.
      */
-    virtual std::vector<surface_iterator_t> enumerate_surfaces(
+    std::vector<surface_iterator_t> enumerate_surfaces(
+        wf::point_t surface_origin = {0, 0});
+
+    /**
+     * Visit each mapped surface in the surface tree, including the surface
+     * itself, in the same order as enumerate_surfaces(), but without
+     * allocating a list.
+     *
+     * @param callback Called with each surface and the coordinates of its
+     *   top-left corner. Returning false stops the iteration.
+     * @param surface_origin The coordinates of the top-left corner of the
+     *   surface.
+     *
+     * @return false if the iteration was stopped by the callback.
+     */
+    bool for_each_surface(
+        wf::function_ref<bool(surface_interface_t*, wf::point_t)> callback,
+        wf::point_t surface_origin = {0, 0});
+
+    /**
+     * Same as for_each_surface(), but visits the surfaces from the bottom-most
+     * to the topmost one, i.e in the order in which they are painted.
+     */
+    bool for_each_surface_reverse(
+        wf::function_ref<bool(surface_interface_t*, wf::point_t)> callback,
         wf::point_t surface_origin = {0, 0});
 
     /**
@@ -137,10 +164,20 @@ class surface_interface_t
      * This is just a hint, so surface implementations don't have to implement
      * this function.
      *
+     * Views cache the opaque region of their surfaces, so implementations
+     * which override this function must call invalidate_opaque_region()
+     * whenever the opaque region changes.
+     *
      * @param origin The coordinates of the upper-left corner of the surface.
      */
     virtual wf::region_t get_opaque_region(wf::point_t origin);
 
+    /**
+     * Notify that the opaque region of the surface has changed. Surfaces
+     * backed by a wlr_surface do this automatically on each commit.
+     */
+    void invalidate_opaque_region();
+
     /**
      * Request that the opaque region is shrunk by a certain amount of pixels
      * from the edge. Surface implementations that implement subtract_opaque
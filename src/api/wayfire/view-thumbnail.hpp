@@ -0,0 +1,55 @@
+#ifndef WF_VIEW_THUMBNAIL_HPP
+#define WF_VIEW_THUMBNAIL_HPP
+
+#include <wayfire/view.hpp>
+#include <wayfire/opengl.hpp>
+
+namespace wf
+{
+/**
+ * A view thumbnail is a cached, downscaled copy of the view's contents
+ * (including subsurfaces), as they look without any transformers.
+ *
+ * Overview plugins which show views at a fraction of their real size can
+ * sample the thumbnail instead of the full-resolution client buffers. The copy
+ * is produced by repeatedly halving the view's snapshot, so it does not alias,
+ * and it is regenerated only after the view's contents are damaged or the
+ * requested size crosses a halving step.
+ *
+ * Core automatically uses the thumbnail for transformers which report a small
+ * enough size via view_transformer_t::get_displayed_size(). The thumbnail is
+ * stored as custom data on the view, so all users share the same copy.
+ */
+class view_thumbnail_t : public wf::custom_data_t, public noncopyable_t
+{
+  public:
+    /** Get the thumbnail of the given view, creating it if necessary. */
+    static nonstd::observer_ptr<view_thumbnail_t> get(wayfire_view view);
+
+    /**
+     * Update the thumbnail if necessary and return its texture.
+     * Must be called outside of render_begin()/render_end().
+     *
+     * @param size The desired size of the thumbnail in framebuffer pixels.
+     *   The actual size is the smallest one reached by halving the snapshot
+     *   which is not smaller than this, so the texture should be sampled
+     *   scaled to the desired size.
+     *
+     * @return The thumbnail texture, which has the same orientation as the
+     *   view's snapshot. Its tex_id is (GLuint)-1 if the view has no contents.
+     */
+    wf::texture_t get_texture(wf::dimensions_t size);
+
+    /** @return The size of the texture last returned by get_texture(). */
+    wf::dimensions_t get_size() const;
+
+    view_thumbnail_t(wayfire_view view);
+    ~view_thumbnail_t();
+
+  private:
+    class impl;
+    std::unique_ptr<impl> priv;
+};
+}
+
+#endif /* end of include guard: WF_VIEW_THUMBNAIL_HPP */
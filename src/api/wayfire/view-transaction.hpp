@@ -0,0 +1,57 @@
+#ifndef WF_VIEW_TRANSACTION_HPP
+#define WF_VIEW_TRANSACTION_HPP
+
+#include <wayfire/view.hpp>
+
+namespace wf
+{
+/**
+ * A view transaction changes the geometry of several views at once, so that
+ * the new layout is presented in a single frame.
+ *
+ * When the transaction is committed, the new geometry is sent to all views,
+ * and the views keep being shown with their old contents and position until
+ * every view has committed its new size, or until the timeout expires. The
+ * rest of the output is repainted as usual in the meantime, so intermediate
+ * layouts are never shown, but nothing else is held back.
+ */
+class view_transaction_t : public noncopyable_t
+{
+  public:
+    /**
+     * Create a new, empty transaction.
+     *
+     * @param timeout The maximal time in milliseconds to wait for the views
+     *   to commit their new size.
+     */
+    view_transaction_t(uint32_t timeout = 100);
+
+    /** Commits the transaction, if it has not been committed yet. */
+    ~view_transaction_t();
+
+    /**
+     * Set the wm geometry of the view when the transaction is committed.
+     * If the view is already part of the transaction, its geometry is updated.
+     * Views which are not mapped at commit time are skipped.
+     */
+    void set_geometry(wayfire_view view, wf::geometry_t geometry);
+
+    /** @return true if no views have been added to the transaction. */
+    bool empty() const;
+
+    /**
+     * Send the new geometry to all views in the transaction.
+     *
+     * Waiting for the views is tracked by core, so the transaction object can
+     * be destroyed right afterwards. Committing a transaction twice has no
+     * effect.
+     */
+    void commit();
+
+  private:
+    class impl;
+    std::unique_ptr<impl> priv;
+};
+}
+
+#endif /* end of include guard: WF_VIEW_TRANSACTION_HPP */
@@ -3,6 +3,7 @@
 
 #include <wayfire/view.hpp>
 #include <wayfire/opengl.hpp>
+#include <glm/mat3x3.hpp>
 
 namespace wf
 {
@@ -84,6 +85,59 @@ class view_transformer_t
      */
     virtual wlr_box get_bounding_box(wf::geometry_t view, wlr_box region);
 
+    /**
+     * Get a serial number which changes whenever the parameters of the
+     * transformer change.
+     *
+     * Core caches the transformed bounding box of the view and the composed
+     * transformation of all of its transformers, and reuses them as long as
+     * the view's geometry, its list of transformers and their serials stay
+     * the same. The default implementation returns 0, which means that the
+     * transformation may change at any time and must not be cached.
+     */
+    virtual uint64_t get_transform_serial()
+    {
+        return 0;
+    }
+
+    /**
+     * Get the transformation as a 2D affine matrix, if it can be expressed
+     * as such.
+     *
+     * If all transformers of a view are affine, core composes them into a
+     * single matrix, so that transforming points and regions does not need
+     * to go through each transformer.
+     *
+     * @param view The bounding box of the view, in output-local coordinates.
+     * @param matrix The matrix which maps output-local points (x, y, 1)
+     *   to their transformed position.
+     *
+     * @return true if the matrix was set. The default implementation returns
+     *   false.
+     */
+    virtual bool get_affine_transform(wf::geometry_t view, glm::mat3& matrix)
+    {
+        return false;
+    }
+
+    /**
+     * Get the approximate size at which the transformer displays the view.
+     *
+     * If this is the first transformer of the view and the returned size is
+     * at most half of the view's size, core passes a cached downscaled copy
+     * of the view as src_tex (see wayfire/view-thumbnail.hpp) instead of the
+     * full-resolution contents. src_box is not affected.
+     *
+     * @param view The bounding box of the view, in output-local coordinates.
+     *
+     * @return The displayed size in logical pixels, or {0, 0} if unknown.
+     *   The default implementation returns {0, 0}.
+     */
+    virtual wf::dimensions_t get_displayed_size(wf::geometry_t view)
+    {
+        return {0, 0};
+    }
+
     /**
      * Render the indicated parts of the view.
      *
@@ -136,8 +190,16 @@ class view_2D : public view_transformer_t
         wf::geometry_t view, wf::pointf_t point) override;
     wf::pointf_t untransform_point(
         wf::geometry_t view, wf::pointf_t point) override;
+    uint64_t get_transform_serial() override;
+    bool get_affine_transform(wf::geometry_t view, glm::mat3& matrix) override;
+    wf::dimensions_t get_displayed_size(wf::geometry_t view) override;
     void render_box(wf::texture_t src_tex, wlr_box src_box,
         wlr_box scissor_box, const wf::framebuffer_t& target_fb) override;
+
+  private:
+    /** The parameters when get_transform_serial() was last called */
+    float last_params[5] = {0, 1, 1, 0, 0};
+    uint64_t serial = 1;
 };
 
 /* Those are centered relative to the view's bounding box */
@@ -150,6 +212,10 @@ class view_3D : public view_transformer_t
     glm::mat4 view_proj{1.0}, translation{1.0}, rotation{1.0}, scaling{1.0};
     glm::vec4 color{1, 1, 1, 1};
 
+    /**
+     * Get the product of all matrices. The result is cached until one of the
+     * matrices or the size of the view's output changes.
+     */
     glm::mat4 calculate_total_transform();
 
   public:
@@ -164,12 +230,26 @@ class view_3D : public view_transformer_t
         wf::geometry_t view, wf::pointf_t point) override;
     wf::pointf_t untransform_point(
         wf::geometry_t view, wf::pointf_t point) override;
+    uint64_t get_transform_serial() override;
+    wf::dimensions_t get_displayed_size(wf::geometry_t view) override;
     void render_box(wf::texture_t src_tex, wlr_box src_box,
         wlr_box scissor_box, const wf::framebuffer_t& target_fb) override;
 
     static const float fov; // PI / 8
     static glm::mat4 default_view_matrix();
     static glm::mat4 default_proj_matrix();
+
+  private:
+    /** The matrices and output size total_transform was computed from */
+    glm::mat4 cached_view_proj{1.0}, cached_translation{1.0},
+        cached_rotation{1.0}, cached_scaling{1.0};
+    wf::dimensions_t cached_output_size = {0, 0};
+    glm::mat4 total_transform{1.0};
+    bool total_transform_valid = false;
+    uint64_t serial = 1;
+
+    /** Recompute total_transform if any of its inputs have changed */
+    void update_total_transform();
 };
 
 /* create a matrix which corresponds to the inverse of the given transform */
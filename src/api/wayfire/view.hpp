@@ -73,6 +73,19 @@ class view_interface_t : public surface_interface_t, public wf::object_base_t
      */
     std::vector<wayfire_view> enumerate_views(bool mapped_only = true);
 
+    /**
+     * Visit all views in the view's tree in the same order as
+     * enumerate_views(), but without allocating a list.
+     *
+     * @param callback Called for each view. Returning false stops the
+     *   iteration.
+     * @param mapped_only Whether to include only mapped views.
+     *
+     * @return false if the iteration was stopped by the callback.
+     */
+    bool for_each_view(wf::function_ref<bool(wayfire_view)> callback,
+        bool mapped_only = true);
+
     /**
      * Set the toplevel parent of the view, and adjust the children's list of
      * the parent.
@@ -0,0 +1,296 @@
+#include "async-log.hpp"
+#include <wayfire/debug.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+
+std::bitset<(size_t)wf::log::logging_category::TOTAL> wf::log::enabled_categories;
+
+bool wf::log::parse_categories(const std::string& list,
+    std::bitset<(size_t)logging_category::TOTAL>& result)
+{
+    static const std::pair<const char*, logging_category> names[] = {
+        {"wlr", logging_category::WLR},
+        {"views", logging_category::VIEWS},
+        {"input", logging_category::INPUT},
+        {"render", logging_category::RENDER},
+        {"xwl", logging_category::XWL},
+        {"plugins", logging_category::PLUGINS},
+    };
+
+    result.reset();
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t end = std::min(list.find(',', start), list.size());
+        std::string name = list.substr(start, end - start);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        start = end + 1;
+
+        if (name.empty())
+        {
+            continue;
+        }
+
+        if (name == "all")
+        {
+            result.set();
+            continue;
+        }
+
+        auto it = std::find_if(std::begin(names), std::end(names),
+            [&] (const auto& entry) { return name == entry.first; });
+        if (it == std::end(names))
+        {
+            return false;
+        }
+
+        result.set((size_t)it->second);
+    }
+
+    return true;
+}
+
+/** Write the whole buffer, using only async-signal-safe functions */
+static void write_all(int fd, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = ::write(fd, data, length);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return;
+        }
+
+        data   += written;
+        length -= written;
+    }
+}
+
+/** Report dropped lines, without using the (non signal-safe) printf family */
+static void write_dropped(int fd, size_t count)
+{
+    char digits[32];
+    int n = 0;
+    do {
+        digits[n++] = '0' + count % 10;
+        count /= 10;
+    } while (count > 0);
+
+    static const char prefix[] = "[async log] dropped ";
+    static const char suffix[] = " message(s)\n";
+
+    char message[sizeof(prefix) + sizeof(digits) + sizeof(suffix)];
+    size_t length = sizeof(prefix) - 1;
+    std::copy(prefix, prefix + length, message);
+    while (n > 0)
+    {
+        message[length++] = digits[--n];
+    }
+
+    std::copy(suffix, suffix + sizeof(suffix) - 1, message + length);
+    length += sizeof(suffix) - 1;
+    write_all(fd, message, length);
+}
+
+wf::async_log_t::async_log_t(int fd, size_t capacity) : fd(fd)
+{
+    size_t size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+
+    ring.resize(size);
+    mask = size - 1;
+    pending.reserve(512);
+    writer = std::thread(&async_log_t::writer_main, this);
+}
+
+wf::async_log_t::~async_log_t()
+{
+    stop();
+}
+
+void wf::async_log_t::stop()
+{
+    if (writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(wakeup_mutex);
+            stopping = true;
+        }
+
+        wakeup.notify_one();
+        writer.join();
+    }
+
+    while (producer_lock.test_and_set(std::memory_order_acquire))
+    {}
+
+    synchronous = true;
+    drain();
+    write_all(fd, pending.data(), pending.size());
+    pending.clear();
+    producer_lock.clear(std::memory_order_release);
+}
+
+void wf::async_log_t::flush_from_signal()
+{
+    synchronous = true;
+
+    /* The writer thread might be in the middle of a write, give it a bit of
+     * time to finish. It may also be the thread which crashed, in which case
+     * we give up after a while. */
+    const timespec delay = {0, 1000000};
+    for (int i = 0; i < 100 && !drain(); i++)
+    {
+        nanosleep(&delay, NULL);
+    }
+}
+
+int wf::async_log_t::overflow(int c)
+{
+    if (c != traits_type::eof())
+    {
+        char ch = c;
+        append(&ch, 1);
+    }
+
+    return traits_type::not_eof(c);
+}
+
+std::streamsize wf::async_log_t::xsputn(const char *s, std::streamsize count)
+{
+    append(s, count);
+
+    return count;
+}
+
+void wf::async_log_t::append(const char *data, size_t length)
+{
+    if (synchronous)
+    {
+        write_all(fd, data, length);
+
+        return;
+    }
+
+    while (producer_lock.test_and_set(std::memory_order_acquire))
+    {}
+
+    pending.append(data, length);
+    size_t line_end = pending.rfind('\n');
+    if (line_end != std::string::npos)
+    {
+        commit(line_end + 1);
+    }
+
+    producer_lock.clear(std::memory_order_release);
+}
+
+void wf::async_log_t::commit(size_t length)
+{
+    size_t h    = head.load(std::memory_order_relaxed);
+    size_t used = h - tail.load(std::memory_order_acquire);
+
+    if (used + length > ring.size())
+    {
+        dropped += std::count(pending.begin(), pending.begin() + length, '\n');
+    } else
+    {
+        size_t start = h & mask;
+        size_t first = std::min(length, ring.size() - start);
+        std::copy(pending.data(), pending.data() + first, ring.data() + start);
+        std::copy(pending.data() + first, pending.data() + length, ring.data());
+        /* Sequentially consistent, so that either the writer sees the new
+         * data before going idle, or we see that it is idle */
+        head.store(h + length);
+
+        if (writer_idle.load())
+        {
+            /* Taking the mutex makes sure the writer is already waiting */
+            {
+                std::lock_guard<std::mutex> lock(wakeup_mutex);
+            }
+
+            wakeup.notify_one();
+        } else if (used + length > ring.size() / 2)
+        {
+            /* Otherwise the writer wakes up on its own after the batching
+             * interval, wake it up early only if the buffer is filling up */
+            wakeup.notify_one();
+        }
+    }
+
+    pending.erase(0, length);
+}
+
+bool wf::async_log_t::drain()
+{
+    if (draining.exchange(true, std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+    if (h != t)
+    {
+        size_t start = t & mask;
+        size_t first = std::min(h - t, ring.size() - start);
+        write_all(fd, ring.data() + start, first);
+        write_all(fd, ring.data(), h - t - first);
+        tail.store(h, std::memory_order_release);
+    }
+
+    size_t lost = dropped.exchange(0);
+    if (lost > 0)
+    {
+        write_dropped(fd, lost);
+    }
+
+    draining.store(false, std::memory_order_release);
+
+    return true;
+}
+
+void wf::async_log_t::writer_main()
+{
+    const auto interval = std::chrono::milliseconds(10);
+    std::unique_lock<std::mutex> lock(wakeup_mutex);
+    while (!stopping)
+    {
+        lock.unlock();
+        drain();
+        lock.lock();
+
+        /* Sleep until something is logged, so that an idle session does not
+         * wake up the writer at all */
+        writer_idle = true;
+        wakeup.wait(lock, [=] ()
+        {
+            return stopping || (head.load() != tail.load());
+        });
+        writer_idle = false;
+
+        /* Batch writes: wait a few milliseconds for more lines, unless the
+         * ring buffer is filling up */
+        wakeup.wait_for(lock, interval, [=] ()
+        {
+            return stopping ||
+            (head.load(std::memory_order_acquire) -
+                tail.load(std::memory_order_relaxed) > ring.size() / 2);
+        });
+    }
+
+    lock.unlock();
+    drain();
+}
@@ -0,0 +1,97 @@
+#ifndef WF_ASYNC_LOG_HPP
+#define WF_ASYNC_LOG_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace wf
+{
+/**
+ * A stream buffer which writes complete lines to a file descriptor from a
+ * background thread.
+ *
+ * Lines are copied into a ring buffer, which the writer thread drains in
+ * batches with a single write(). Logging thus never blocks the compositor on
+ * the terminal or the journal. If the writer cannot keep up and the ring
+ * buffer is full, messages are dropped and their number is reported later.
+ */
+class async_log_t : public std::streambuf
+{
+  public:
+    /**
+     * Start the writer thread.
+     *
+     * @param fd The file descriptor to write to.
+     * @param capacity The size of the ring buffer, rounded up to a power of 2.
+     */
+    async_log_t(int fd, size_t capacity = 1 << 20);
+    ~async_log_t();
+
+    /**
+     * Write out all pending messages, stop the writer thread and write any
+     * further messages synchronously.
+     */
+    void stop();
+
+    /**
+     * Write out all pending messages from the calling thread and switch to
+     * synchronous writes. Uses only async-signal-safe functions, so it can be
+     * used from a signal handler right before the process exits.
+     */
+    void flush_from_signal();
+
+  protected:
+    int overflow(int c) override;
+    std::streamsize xsputn(const char *s, std::streamsize count) override;
+
+  private:
+    const int fd;
+    std::vector<char> ring;
+    size_t mask;
+
+    /* Position of the next byte to write, only changed by the producer */
+    std::atomic<size_t> head{0};
+    /* Position of the next byte to read, only changed by the consumer */
+    std::atomic<size_t> tail{0};
+    /* Number of lines which did not fit into the ring buffer */
+    std::atomic<size_t> dropped{0};
+
+    /* Serializes producers. Logging usually happens only on the main thread,
+     * so this is almost never contended. */
+    std::atomic_flag producer_lock = ATOMIC_FLAG_INIT;
+    /* Held by whoever is currently draining the ring buffer */
+    std::atomic<bool> draining{false};
+    /* Set once messages should be written directly */
+    std::atomic<bool> synchronous{false};
+    std::atomic<bool> stopping{false};
+
+    /* The current line, not yet committed to the ring buffer */
+    std::string pending;
+
+    std::thread writer;
+    std::mutex wakeup_mutex;
+    std::condition_variable wakeup;
+    /* Set while the writer sleeps until the ring buffer becomes non-empty */
+    std::atomic<bool> writer_idle{false};
+
+    /** Append data to the pending line and commit all complete lines */
+    void append(const char *data, size_t length);
+    /** Copy the complete lines from the pending buffer to the ring buffer */
+    void commit(size_t length);
+
+    /**
+     * Write out the contents of the ring buffer.
+     * @return false if another thread is draining the buffer at the moment.
+     */
+    bool drain();
+
+    void writer_main();
+};
+}
+
+#endif /* end of include guard: WF_ASYNC_LOG_HPP */
@@ -0,0 +1,589 @@
+#include "input-replay.hpp"
+#include <wayfire/core.hpp>
+#include <wayfire/debug.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/nonstd/wlroots-full.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const char RECORDING_MAGIC[8] = "WFINPUT";
+static const uint32_t RECORDING_VERSION = 1;
+/** How often the recording is flushed to disk */
+static const uint32_t FLUSH_INTERVAL_MS = 1000;
+
+/**
+ * Write or read the fields of a record which its type uses.
+ * The same function describes the format in both directions, so reading and
+ * writing cannot get out of sync.
+ */
+template<class Transfer>
+static void transfer_record(Transfer& transfer, wf::input_record_t& r)
+{
+    transfer(r.time_msec);
+    switch (r.type)
+    {
+      case wf::INPUT_RECORD_KEY:
+      case wf::INPUT_RECORD_POINTER_BUTTON:
+        transfer(r.code);
+        transfer(r.state);
+        break;
+
+      case wf::INPUT_RECORD_POINTER_MOTION:
+        transfer(r.values[0]);
+        transfer(r.values[1]);
+        transfer(r.values[2]);
+        transfer(r.values[3]);
+        break;
+
+      case wf::INPUT_RECORD_POINTER_MOTION_ABSOLUTE:
+        transfer(r.values[0]);
+        transfer(r.values[1]);
+        break;
+
+      case wf::INPUT_RECORD_POINTER_AXIS:
+        transfer(r.state);
+        transfer(r.orientation);
+        transfer(r.discrete);
+        transfer(r.values[0]);
+        break;
+
+      case wf::INPUT_RECORD_SWIPE_BEGIN:
+      case wf::INPUT_RECORD_PINCH_BEGIN:
+      case wf::INPUT_RECORD_TOUCH_UP:
+        transfer(r.code);
+        break;
+
+      case wf::INPUT_RECORD_SWIPE_UPDATE:
+        transfer(r.code);
+        transfer(r.values[0]);
+        transfer(r.values[1]);
+        break;
+
+      case wf::INPUT_RECORD_PINCH_UPDATE:
+        transfer(r.code);
+        transfer(r.values[0]);
+        transfer(r.values[1]);
+        transfer(r.values[2]);
+        transfer(r.values[3]);
+        break;
+
+      case wf::INPUT_RECORD_SWIPE_END:
+      case wf::INPUT_RECORD_PINCH_END:
+        transfer(r.state);
+        break;
+
+      case wf::INPUT_RECORD_TOUCH_DOWN:
+      case wf::INPUT_RECORD_TOUCH_MOTION:
+        transfer(r.code);
+        transfer(r.values[0]);
+        transfer(r.values[1]);
+        break;
+    }
+}
+
+template<class wlr_event_t>
+void wf::input_recorder_t::record(std::string signal,
+    void (*convert)(wlr_event_t*, input_record_t&))
+{
+    auto connection = std::make_unique<wf::signal_connection_t>(
+        [=] (wf::signal_data_t *data)
+    {
+        auto ev = static_cast<wf::input_event_signal<wlr_event_t>*>(data);
+        input_record_t record;
+        record.time_msec = ev->event->time_msec;
+        convert(ev->event, record);
+        write(record);
+    });
+
+    wf::get_core().connect_signal(signal, connection.get());
+    connections.push_back(std::move(connection));
+}
+
+wf::input_recorder_t::input_recorder_t(std::string file_name) :
+    out(file_name, std::ios::binary | std::ios::trunc), file_name(file_name)
+{
+    if (!out)
+    {
+        LOGE("Failed to open ", file_name, " for recording input");
+
+        return;
+    }
+
+    uint32_t start_msec = wf::get_current_time();
+    out.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    out.write((const char*)&RECORDING_VERSION, sizeof(RECORDING_VERSION));
+    out.write((const char*)&start_msec, sizeof(start_msec));
+    last_flush_msec = start_msec;
+
+    record<wlr_event_keyboard_key>("keyboard_key", [] (auto ev, auto& r)
+    {
+        r.type  = INPUT_RECORD_KEY;
+        r.code  = ev->keycode;
+        r.state = ev->state;
+    });
+
+    record<wlr_event_pointer_motion>("pointer_motion", [] (auto ev, auto& r)
+    {
+        r.type      = INPUT_RECORD_POINTER_MOTION;
+        r.values[0] = ev->delta_x;
+        r.values[1] = ev->delta_y;
+        r.values[2] = ev->unaccel_dx;
+        r.values[3] = ev->unaccel_dy;
+    });
+
+    record<wlr_event_pointer_motion_absolute>("pointer_motion_absolute",
+        [] (auto ev, auto& r)
+    {
+        r.type      = INPUT_RECORD_POINTER_MOTION_ABSOLUTE;
+        r.values[0] = ev->x;
+        r.values[1] = ev->y;
+    });
+
+    record<wlr_event_pointer_button>("pointer_button", [] (auto ev, auto& r)
+    {
+        r.type  = INPUT_RECORD_POINTER_BUTTON;
+        r.code  = ev->button;
+        r.state = ev->state;
+    });
+
+    record<wlr_event_pointer_axis>("pointer_axis", [] (auto ev, auto& r)
+    {
+        r.type        = INPUT_RECORD_POINTER_AXIS;
+        r.state       = ev->source;
+        r.orientation = ev->orientation;
+        r.discrete    = ev->delta_discrete;
+        r.values[0]   = ev->delta;
+    });
+
+    record<wlr_event_pointer_swipe_begin>("pointer_swipe_begin",
+        [] (auto ev, auto& r)
+    {
+        r.type = INPUT_RECORD_SWIPE_BEGIN;
+        r.code = ev->fingers;
+    });
+
+    record<wlr_event_pointer_swipe_update>("pointer_swipe_update",
+        [] (auto ev, auto& r)
+    {
+        r.type      = INPUT_RECORD_SWIPE_UPDATE;
+        r.code      = ev->fingers;
+        r.values[0] = ev->dx;
+        r.values[1] = ev->dy;
+    });
+
+    record<wlr_event_pointer_swipe_end>("pointer_swipe_end", [] (auto ev, auto& r)
+    {
+        r.type  = INPUT_RECORD_SWIPE_END;
+        r.state = ev->cancelled;
+    });
+
+    record<wlr_event_pointer_pinch_begin>("pointer_pinch_begin",
+        [] (auto ev, auto& r)
+    {
+        r.type = INPUT_RECORD_PINCH_BEGIN;
+        r.code = ev->fingers;
+    });
+
+    record<wlr_event_pointer_pinch_update>("pointer_pinch_update",
+        [] (auto ev, auto& r)
+    {
+        r.type      = INPUT_RECORD_PINCH_UPDATE;
+        r.code      = ev->fingers;
+        r.values[0] = ev->dx;
+        r.values[1] = ev->dy;
+        r.values[2] = ev->scale;
+        r.values[3] = ev->rotation;
+    });
+
+    record<wlr_event_pointer_pinch_end>("pointer_pinch_end", [] (auto ev, auto& r)
+    {
+        r.type  = INPUT_RECORD_PINCH_END;
+        r.state = ev->cancelled;
+    });
+
+    record<wlr_event_touch_down>("touch_down", [] (auto ev, auto& r)
+    {
+        r.type      = INPUT_RECORD_TOUCH_DOWN;
+        r.code      = ev->touch_id;
+        r.values[0] = ev->x;
+        r.values[1] = ev->y;
+    });
+
+    record<wlr_event_touch_up>("touch_up", [] (auto ev, auto& r)
+    {
+        r.type = INPUT_RECORD_TOUCH_UP;
+        r.code = ev->touch_id;
+    });
+
+    record<wlr_event_touch_motion>("touch_motion", [] (auto ev, auto& r)
+    {
+        r.type      = INPUT_RECORD_TOUCH_MOTION;
+        r.code      = ev->touch_id;
+        r.values[0] = ev->x;
+        r.values[1] = ev->y;
+    });
+
+    LOGI("Recording input to ", file_name);
+}
+
+wf::input_recorder_t::~input_recorder_t()
+{
+    connections.clear();
+    if (out)
+    {
+        out.flush();
+        LOGI("Recorded ", num_events, " input events to ", file_name);
+    }
+}
+
+void wf::input_recorder_t::write(input_record_t& record)
+{
+    if (!out)
+    {
+        return;
+    }
+
+    auto writer = [&] (auto& value)
+    {
+        out.write((const char*)&value, sizeof(value));
+    };
+
+    writer(record.type);
+    transfer_record(writer, record);
+    ++num_events;
+
+    /* Keep the file usable even if the compositor crashes */
+    uint32_t now = wf::get_current_time();
+    if (now - last_flush_msec >= FLUSH_INTERVAL_MS)
+    {
+        out.flush();
+        last_flush_msec = now;
+    }
+
+    if (!out)
+    {
+        LOGE("Failed to write to input recording ", file_name);
+    }
+}
+
+wf::input_replay_t::input_replay_t(std::string file_name, double speed) :
+    file_name(file_name), speed(speed)
+{
+    if (!(speed > 0))
+    {
+        LOGE("Invalid input replay speed ", speed);
+
+        return;
+    }
+
+    if (!load())
+    {
+        return;
+    }
+
+    auto& core = wf::get_core();
+    if (!wlr_backend_is_multi(core.backend))
+    {
+        LOGE("Cannot replay input: the backend does not support adding ",
+            "virtual input devices");
+
+        return;
+    }
+
+    headless = wlr_headless_backend_create_with_renderer(core.display,
+        core.renderer);
+    if (!headless || !wlr_multi_backend_add(core.backend, headless))
+    {
+        LOGE("Cannot replay input: failed to create a headless backend");
+
+        return;
+    }
+
+    valid = true;
+}
+
+wf::input_replay_t::~input_replay_t()
+{
+    if (timer)
+    {
+        wl_event_source_remove(timer);
+    }
+}
+
+bool wf::input_replay_t::is_valid() const
+{
+    return valid;
+}
+
+bool wf::input_replay_t::load()
+{
+    std::ifstream in(file_name, std::ios::binary);
+    if (!in)
+    {
+        LOGE("Failed to open input recording ", file_name);
+
+        return false;
+    }
+
+    char magic[sizeof(RECORDING_MAGIC)];
+    uint32_t version = 0;
+    in.read(magic, sizeof(magic));
+    in.read((char*)&version, sizeof(version));
+    in.read((char*)&record_start_msec, sizeof(record_start_msec));
+    if (!in || std::memcmp(magic, RECORDING_MAGIC, sizeof(magic)) ||
+        (version != RECORDING_VERSION))
+    {
+        LOGE(file_name, " is not an input recording of a supported version");
+
+        return false;
+    }
+
+    bool failed = false;
+    auto reader = [&] (auto& value)
+    {
+        failed |= !in.read((char*)&value, sizeof(value));
+    };
+
+    input_record_t record;
+    while (in.read((char*)&record.type, sizeof(record.type)))
+    {
+        if ((record.type < INPUT_RECORD_KEY) ||
+            (record.type > INPUT_RECORD_TOUCH_MOTION))
+        {
+            LOGE("Unknown event type ", (int)record.type, " in ", file_name);
+
+            return false;
+        }
+
+        transfer_record(reader, record);
+        if (failed)
+        {
+            /* The recording was cut off, e.g. by a crash */
+            LOGW("Input recording ", file_name, " is truncated");
+            break;
+        }
+
+        records.push_back(record);
+    }
+
+    LOGI("Loaded ", records.size(), " input events from ", file_name);
+
+    return true;
+}
+
+void wf::input_replay_t::start()
+{
+    if (!valid)
+    {
+        return;
+    }
+
+    keyboard = wlr_headless_add_input_device(headless,
+        WLR_INPUT_DEVICE_KEYBOARD);
+    pointer = wlr_headless_add_input_device(headless, WLR_INPUT_DEVICE_POINTER);
+    touch   = wlr_headless_add_input_device(headless, WLR_INPUT_DEVICE_TOUCH);
+    if (!keyboard || !pointer || !touch)
+    {
+        LOGE("Cannot replay input: failed to create virtual input devices");
+
+        return;
+    }
+
+    replay_start_msec = wf::get_current_time();
+    timer = wl_event_loop_add_timer(wf::get_core().ev_loop, handle_timer, this);
+    dispatch();
+}
+
+uint32_t wf::input_replay_t::due_time(const input_record_t& record) const
+{
+    /* Unsigned arithmetic handles the wrap-around of the millisecond clock */
+    uint32_t offset = record.time_msec - record_start_msec;
+
+    return replay_start_msec + (uint32_t)std::llround(offset / speed);
+}
+
+int wf::input_replay_t::handle_timer(void *data)
+{
+    static_cast<input_replay_t*>(data)->dispatch();
+
+    return 0;
+}
+
+void wf::input_replay_t::dispatch()
+{
+    uint32_t now = wf::get_current_time();
+    while (next_record < records.size())
+    {
+        int32_t wait = due_time(records[next_record]) - now;
+        if (wait > 0)
+        {
+            wl_event_source_timer_update(timer, wait);
+
+            return;
+        }
+
+        send(records[next_record++], now);
+    }
+
+    LOGI("Finished replaying ", records.size(), " input events from ",
+        file_name, " in ", wf::get_current_time() - replay_start_msec, "ms");
+}
+
+void wf::input_replay_t::send(const input_record_t& r, uint32_t time_msec)
+{
+    /* Pointer events are grouped into frames, as real devices do */
+    auto send_pointer = [&] (wl_signal& signal, auto& ev)
+    {
+        ev.device    = pointer;
+        ev.time_msec = time_msec;
+        wl_signal_emit(&signal, &ev);
+        wl_signal_emit(&pointer->pointer->events.frame, pointer->pointer);
+    };
+
+    auto send_touch = [&] (wl_signal& signal, auto& ev)
+    {
+        ev.device    = touch;
+        ev.time_msec = time_msec;
+        ev.touch_id  = r.code;
+        wl_signal_emit(&signal, &ev);
+    };
+
+    auto& pointer_events = pointer->pointer->events;
+    auto& touch_events   = touch->touch->events;
+
+    switch (r.type)
+    {
+      case INPUT_RECORD_KEY:
+    {
+        wlr_event_keyboard_key ev;
+        ev.time_msec    = time_msec;
+        ev.keycode      = r.code;
+        ev.update_state = true;
+        ev.state = (wlr_key_state)r.state;
+        wlr_keyboard_notify_key(keyboard->keyboard, &ev);
+        break;
+    }
+
+      case INPUT_RECORD_POINTER_MOTION:
+    {
+        wlr_event_pointer_motion ev;
+        ev.delta_x    = r.values[0];
+        ev.delta_y    = r.values[1];
+        ev.unaccel_dx = r.values[2];
+        ev.unaccel_dy = r.values[3];
+        send_pointer(pointer_events.motion, ev);
+        break;
+    }
+
+      case INPUT_RECORD_POINTER_MOTION_ABSOLUTE:
+    {
+        wlr_event_pointer_motion_absolute ev;
+        ev.x = r.values[0];
+        ev.y = r.values[1];
+        send_pointer(pointer_events.motion_absolute, ev);
+        break;
+    }
+
+      case INPUT_RECORD_POINTER_BUTTON:
+    {
+        wlr_event_pointer_button ev;
+        ev.button = r.code;
+        ev.state  = (wlr_button_state)r.state;
+        send_pointer(pointer_events.button, ev);
+        break;
+    }
+
+      case INPUT_RECORD_POINTER_AXIS:
+    {
+        wlr_event_pointer_axis ev;
+        ev.source = (wlr_axis_source)r.state;
+        ev.orientation    = (wlr_axis_orientation)r.orientation;
+        ev.delta_discrete = r.discrete;
+        ev.delta = r.values[0];
+        send_pointer(pointer_events.axis, ev);
+        break;
+    }
+
+      case INPUT_RECORD_SWIPE_BEGIN:
+    {
+        wlr_event_pointer_swipe_begin ev;
+        ev.fingers = r.code;
+        send_pointer(pointer_events.swipe_begin, ev);
+        break;
+    }
+
+      case INPUT_RECORD_SWIPE_UPDATE:
+    {
+        wlr_event_pointer_swipe_update ev;
+        ev.fingers = r.code;
+        ev.dx = r.values[0];
+        ev.dy = r.values[1];
+        send_pointer(pointer_events.swipe_update, ev);
+        break;
+    }
+
+      case INPUT_RECORD_SWIPE_END:
+    {
+        wlr_event_pointer_swipe_end ev;
+        ev.cancelled = r.state;
+        send_pointer(pointer_events.swipe_end, ev);
+        break;
+    }
+
+      case INPUT_RECORD_PINCH_BEGIN:
+    {
+        wlr_event_pointer_pinch_begin ev;
+        ev.fingers = r.code;
+        send_pointer(pointer_events.pinch_begin, ev);
+        break;
+    }
+
+      case INPUT_RECORD_PINCH_UPDATE:
+    {
+        wlr_event_pointer_pinch_update ev;
+        ev.fingers  = r.code;
+        ev.dx       = r.values[0];
+        ev.dy       = r.values[1];
+        ev.scale    = r.values[2];
+        ev.rotation = r.values[3];
+        send_pointer(pointer_events.pinch_update, ev);
+        break;
+    }
+
+      case INPUT_RECORD_PINCH_END:
+    {
+        wlr_event_pointer_pinch_end ev;
+        ev.cancelled = r.state;
+        send_pointer(pointer_events.pinch_end, ev);
+        break;
+    }
+
+      case INPUT_RECORD_TOUCH_DOWN:
+    {
+        wlr_event_touch_down ev;
+        ev.x = r.values[0];
+        ev.y = r.values[1];
+        send_touch(touch_events.down, ev);
+        break;
+    }
+
+      case INPUT_RECORD_TOUCH_UP:
+    {
+        wlr_event_touch_up ev;
+        send_touch(touch_events.up, ev);
+        break;
+    }
+
+      case INPUT_RECORD_TOUCH_MOTION:
+    {
+        wlr_event_touch_motion ev;
+        ev.x = r.values[0];
+        ev.y = r.values[1];
+        send_touch(touch_events.motion, ev);
+        break;
+    }
+    }
+}
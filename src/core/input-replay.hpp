@@ -0,0 +1,146 @@
+#ifndef WF_INPUT_REPLAY_HPP
+#define WF_INPUT_REPLAY_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <wayfire/object.hpp>
+#include <wayfire/nonstd/wlroots.hpp>
+
+namespace wf
+{
+/** The kinds of events stored in an input recording */
+enum input_record_type_t : uint8_t
+{
+    INPUT_RECORD_KEY                     = 1,
+    INPUT_RECORD_POINTER_MOTION          = 2,
+    INPUT_RECORD_POINTER_MOTION_ABSOLUTE = 3,
+    INPUT_RECORD_POINTER_BUTTON          = 4,
+    INPUT_RECORD_POINTER_AXIS            = 5,
+    INPUT_RECORD_SWIPE_BEGIN             = 6,
+    INPUT_RECORD_SWIPE_UPDATE            = 7,
+    INPUT_RECORD_SWIPE_END               = 8,
+    INPUT_RECORD_PINCH_BEGIN             = 9,
+    INPUT_RECORD_PINCH_UPDATE            = 10,
+    INPUT_RECORD_PINCH_END               = 11,
+    INPUT_RECORD_TOUCH_DOWN              = 12,
+    INPUT_RECORD_TOUCH_UP                = 13,
+    INPUT_RECORD_TOUCH_MOTION            = 14,
+};
+
+/**
+ * A single recorded input event. Only the fields used by the event type are
+ * stored in the recording.
+ */
+struct input_record_t
+{
+    input_record_type_t type;
+    /** The timestamp of the event, in milliseconds of CLOCK_MONOTONIC */
+    uint32_t time_msec = 0;
+    /** Keycode, button, touch point id or number of fingers */
+    uint32_t code = 0;
+    /** Key or button state, axis source, whether a gesture was cancelled */
+    uint8_t state = 0;
+    /** Axis orientation */
+    uint8_t orientation = 0;
+    /** Discrete axis steps */
+    int32_t discrete = 0;
+    /** Deltas, positions, gesture scale and rotation, depending on the type */
+    double values[4] = {0, 0, 0, 0};
+};
+
+/**
+ * Records the input events of the seat to a file.
+ *
+ * The events are captured from the device signals of core, so they are
+ * recorded exactly as they reach the seat, before any plugin has handled
+ * them. Tablet events are not recorded.
+ *
+ * The file starts with a header (the magic "WFINPUT", the format version and
+ * the time at which the recording started), followed by the events. Each event
+ * is its type, its timestamp and only the fields its type uses. Numbers are
+ * stored in the byte order of the host, so recordings are meant to be replayed
+ * on the same kind of machine they were made on.
+ */
+class input_recorder_t
+{
+  public:
+    /** Start recording to the given file. */
+    input_recorder_t(std::string file_name);
+    /** Stop recording and flush the file. */
+    ~input_recorder_t();
+
+  private:
+    std::ofstream out;
+    std::string file_name;
+    uint64_t num_events = 0;
+    uint32_t last_flush_msec = 0;
+
+    std::vector<std::unique_ptr<wf::signal_connection_t>> connections;
+    template<class wlr_event_t>
+    void record(std::string signal,
+        void (*convert)(wlr_event_t*, input_record_t&));
+    void write(input_record_t& record);
+};
+
+/**
+ * Replays a recording made by input_recorder_t.
+ *
+ * The events are sent through virtual keyboard, pointer and touch devices of a
+ * headless backend, so they take the same path through core and plugins as
+ * real input. Their timestamps are replaced with the current time when they
+ * are sent.
+ */
+class input_replay_t
+{
+  public:
+    /**
+     * Load a recording and add the headless backend for the virtual devices.
+     * Has to be called before the backend of core is started.
+     *
+     * @param file_name The recording to replay.
+     * @param speed How much faster than the original the events are sent.
+     */
+    input_replay_t(std::string file_name, double speed);
+    ~input_replay_t();
+
+    /** @return Whether the recording was loaded successfully. */
+    bool is_valid() const;
+
+    /**
+     * Create the virtual devices and start sending the events.
+     * Has to be called after core has been initialized.
+     */
+    void start();
+
+  private:
+    std::string file_name;
+    double speed;
+    bool valid = false;
+
+    uint32_t record_start_msec = 0;
+    std::vector<input_record_t> records;
+    size_t next_record = 0;
+    uint32_t replay_start_msec = 0;
+
+    wlr_backend *headless = nullptr;
+    wlr_input_device *keyboard = nullptr;
+    wlr_input_device *pointer  = nullptr;
+    wlr_input_device *touch    = nullptr;
+    wl_event_source *timer     = nullptr;
+
+    bool load();
+    /** The time at which the given record should be sent */
+    uint32_t due_time(const input_record_t& record) const;
+    /** Send all events which are due and schedule the next one */
+    void dispatch();
+    void send(const input_record_t& record, uint32_t time_msec);
+
+    static int handle_timer(void *data);
+};
+}
+
+#endif /* end of include guard: WF_INPUT_REPLAY_HPP */
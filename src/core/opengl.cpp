@@ -1,5 +1,12 @@
 #include <wayfire/util/log.hpp>
 #include <map>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <optional>
+#include <cstring>
+#include <unistd.h>
 #include "opengl-priv.hpp"
 #include "wayfire/output.hpp"
 #include "core-impl.hpp"
@@ -10,6 +17,12 @@
 
 #include "shaders.tpp"
 
+namespace OpenGL
+{
+/* Updated by gl_call(), render_begin() and framebuffer_base_t */
+static render_counters_t counters;
+}
+
 const char *gl_error_string(const GLenum err)
 {
     switch (err)
@@ -32,6 +45,11 @@ const char *gl_error_string(const GLenum err)
 
 void gl_call(const char *func, uint32_t line, const char *glfunc)
 {
+    if (std::strncmp(glfunc, "glDraw", 6) == 0)
+    {
+        ++OpenGL::counters.draw_calls;
+    }
+
     GLenum err;
     if ((err = glGetError()) == GL_NO_ERROR)
     {
@@ -74,20 +92,210 @@ GLuint compile_shader(std::string source, GLuint type)
     return shader;
 }
 
+/**
+ * A cache of linked program binaries on disk, so that programs do not have to
+ * be compiled again on each start.
+ *
+ * Binaries are stored in $XDG_CACHE_HOME/wayfire/shaders, keyed by a hash of
+ * the shader sources and the GL vendor, renderer and version strings. If the
+ * driver rejects a cached binary, the program is compiled from source and the
+ * binary is replaced.
+ */
+namespace shader_cache
+{
+/** 64-bit FNV-1a, which unlike std::hash is stable across builds */
+static uint64_t hash_string(const std::string& str, uint64_t hash)
+{
+    for (unsigned char c : str)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/** @return The directory of the cache, or empty if caching is not possible */
+static const std::filesystem::path& get_directory()
+{
+    static std::optional<std::filesystem::path> directory;
+    if (directory)
+    {
+        return *directory;
+    }
+
+    directory = std::filesystem::path{};
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0)
+    {
+        LOGI("GL driver does not support program binaries, not caching shaders");
+
+        return *directory;
+    }
+
+    std::filesystem::path cache_home;
+    if (const char *xdg_cache_home = getenv("XDG_CACHE_HOME"))
+    {
+        cache_home = xdg_cache_home;
+    } else if (const char *home = getenv("HOME"))
+    {
+        cache_home = std::filesystem::path(home) / ".cache";
+    } else
+    {
+        return *directory;
+    }
+
+    auto path = cache_home / "wayfire" / "shaders";
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    if (ec)
+    {
+        LOGE("Failed to create shader cache directory ", path.string(), ": ",
+            ec.message());
+    } else
+    {
+        directory = path;
+    }
+
+    return *directory;
+}
+
+static std::filesystem::path get_path(const std::string& vertex_source,
+    const std::string& frag_source)
+{
+    static std::string driver;
+    if (driver.empty())
+    {
+        for (auto name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+        {
+            auto str = glGetString(name);
+            driver += (str ? (const char*)str : "") + std::string("\n");
+        }
+    }
+
+    uint64_t hash = 14695981039346656037ull;
+    hash = hash_string(driver, hash);
+    hash = hash_string(vertex_source, hash);
+    hash = hash_string(frag_source, hash);
+
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+
+    return get_directory() / name.str();
+}
+
+/** Try to load the program from the cache. @return 0 on failure */
+static GLuint load(const std::filesystem::path& path)
+{
+    std::ifstream file{path, std::ios::binary};
+    GLenum format;
+    if (!file.read((char*)&format, sizeof(format)))
+    {
+        return 0;
+    }
+
+    std::vector<char> binary{std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>()};
+
+    GLuint program = GL_CALL(glCreateProgram());
+    glProgramBinary(program, format, binary.data(), binary.size());
+
+    /* Rejected binaries can set GL errors, which should not be reported */
+    while (glGetError() != GL_NO_ERROR)
+    {}
+
+    GLint status = GL_FALSE;
+    GL_CALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    if (status == GL_FALSE)
+    {
+        LOGD("Cached shader ", path.string(), " was rejected, recompiling");
+        GL_CALL(glDeleteProgram(program));
+
+        return 0;
+    }
+
+    return program;
+}
+
+/** Store the binary of a linked program in the cache */
+static void store(const std::filesystem::path& path, GLuint program)
+{
+    GLint length = 0;
+    GL_CALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0)
+    {
+        return;
+    }
+
+    GLenum format;
+    std::vector<char> binary(length);
+    GL_CALL(glGetProgramBinary(program, length, &length, &format, binary.data()));
+
+    /* Write to a temporary file first, so that concurrent instances never
+     * read a partially written binary */
+    auto tmp_path = path;
+    tmp_path += "." + std::to_string(getpid());
+    {
+        std::ofstream file{tmp_path, std::ios::binary | std::ios::trunc};
+        file.write((char*)&format, sizeof(format));
+        file.write(binary.data(), length);
+        if (!file)
+        {
+            LOGE("Failed to write shader cache ", tmp_path.string());
+
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tmp_path, ec);
+    }
+}
+}
+
 /* Create a very simple gl program from the given shader sources */
 GLuint compile_program(std::string vertex_source, std::string frag_source)
 {
+    bool use_cache = !shader_cache::get_directory().empty();
+    std::filesystem::path cache_path;
+    if (use_cache)
+    {
+        cache_path = shader_cache::get_path(vertex_source, frag_source);
+        if (GLuint program = shader_cache::load(cache_path))
+        {
+            return program;
+        }
+    }
+
     auto vertex_shader   = compile_shader(vertex_source, GL_VERTEX_SHADER);
     auto fragment_shader = compile_shader(frag_source, GL_FRAGMENT_SHADER);
     auto result_program  = GL_CALL(glCreateProgram());
     GL_CALL(glAttachShader(result_program, vertex_shader));
     GL_CALL(glAttachShader(result_program, fragment_shader));
+    if (use_cache)
+    {
+        GL_CALL(glProgramParameteri(result_program,
+            GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+
     GL_CALL(glLinkProgram(result_program));
 
     /* won't be really deleted until program is deleted as well */
     GL_CALL(glDeleteShader(vertex_shader));
     GL_CALL(glDeleteShader(fragment_shader));
 
+    GLint status = GL_FALSE;
+    GL_CALL(glGetProgramiv(result_program, GL_LINK_STATUS, &status));
+    if (use_cache && (status == GL_TRUE))
+    {
+        shader_cache::store(cache_path, result_program);
+    }
+
     return result_program;
 }
 
@@ -130,6 +338,27 @@ void unbind_output(wf::output_t *output)
     current_output_fb = 0;
 }
 
+/**
+ * Draw the quad set up in the active program. Opaque quads are drawn without
+ * blending, which saves memory bandwidth, as the framebuffer does not have to
+ * be read. Blending is enabled again afterwards, because custom rendering code
+ * expects it to be on.
+ */
+static void draw_quad(bool opaque)
+{
+    GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    if (opaque)
+    {
+        GL_CALL(glDisable(GL_BLEND));
+        GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
+        GL_CALL(glEnable(GL_BLEND));
+    } else
+    {
+        GL_CALL(glEnable(GL_BLEND));
+        GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
+    }
+}
+
 void render_transformed_texture(wf::texture_t tex,
     const gl_geometry& g, const gl_geometry& texg,
     glm::mat4 model, glm::vec4 color, uint32_t bits)
@@ -179,9 +408,10 @@ void render_transformed_texture(wf::texture_t tex,
     program.uniformMatrix4f("MVP", model);
     program.uniform4f("color", color);
 
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
-    GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
+    /* RGBX textures are always drawn with alpha 1 */
+    bool opaque = ((bits & TEXTURE_OPAQUE) ||
+        (tex.type == wf::TEXTURE_TYPE_RGBX)) && (color.a >= 1.0f);
+    draw_quad(opaque);
 
     program.deactivate();
 }
@@ -225,18 +455,28 @@ void render_rectangle(wf::geometry_t geometry, wf::color_t color,
     color_program.attrib_pointer("position", 2, 0, vertexData);
     color_program.uniformMatrix4f("MVP", matrix);
     color_program.uniform4f("color", {color.r, color.g, color.b, color.a});
-
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
-    GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
+    draw_quad(color.a >= 1.0);
 
     color_program.deactivate();
 }
 
+static void begin_rendering(int32_t viewport_width, int32_t viewport_height,
+    uint32_t fb)
+{
+    if (!wlr_egl_is_current(wf::get_core_impl().egl))
+    {
+        wlr_egl_make_current(wf::get_core_impl().egl, EGL_NO_SURFACE, NULL);
+    }
+
+    wlr_renderer_begin(wf::get_core_impl().renderer,
+        viewport_width, viewport_height);
+    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, fb));
+}
+
 void render_begin()
 {
     /* No real reason for 10, 10, 0 but it doesn't matter */
-    render_begin(10, 10, 0);
+    begin_rendering(10, 10, 0);
 }
 
 void render_begin(const wf::framebuffer_base_t& fb)
@@ -246,14 +486,13 @@ void render_begin(const wf::framebuffer_base_t& fb)
 
 void render_begin(int32_t viewport_width, int32_t viewport_height, uint32_t fb)
 {
-    if (!wlr_egl_is_current(wf::get_core_impl().egl))
-    {
-        wlr_egl_make_current(wf::get_core_impl().egl, EGL_NO_SURFACE, NULL);
-    }
+    ++counters.render_passes;
+    begin_rendering(viewport_width, viewport_height, fb);
+}
 
-    wlr_renderer_begin(wf::get_core_impl().renderer,
-        viewport_width, viewport_height);
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, fb));
+const render_counters_t& get_render_counters()
+{
+    return counters;
 }
 
 void clear(wf::color_t col, uint32_t mask)
@@ -301,7 +540,8 @@ bool wf::framebuffer_base_t::allocate(int width, int height)
         GL_CALL(glGenFramebuffers(1, &fb));
     }
 
-    if (tex == (uint32_t)-1)
+    bool new_texture = (tex == (uint32_t)-1);
+    if (new_texture)
     {
         first_allocate = true;
         GL_CALL(glGenTextures(1, &tex));
@@ -321,6 +561,13 @@ bool wf::framebuffer_base_t::allocate(int width, int height)
             (height != viewport_height))
         {
             is_resize = true;
+            if (!new_texture)
+            {
+                OpenGL::counters.framebuffer_memory -=
+                    4ll * viewport_width * viewport_height;
+            }
+
+            OpenGL::counters.framebuffer_memory += 4ll * width * height;
             GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
             GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height,
                 0, GL_RGBA, GL_UNSIGNED_BYTE, 0));
@@ -405,6 +652,12 @@ void wf::framebuffer_base_t::release()
 
     if ((tex != uint32_t(-1)) && ((fb != 0) || (tex != 0)))
     {
+        if (tex != 0)
+        {
+            OpenGL::counters.framebuffer_memory -=
+                4ll * viewport_width * viewport_height;
+        }
+
         GL_CALL(glDeleteTextures(1, &tex));
     }
 
@@ -545,6 +798,25 @@ class program_t::impl
     int active_program_idx = 0;
 
     int id[wf::TEXTURE_TYPE_ALL];
+
+    /**
+     * The sources of the variants which have not been compiled yet.
+     * Variants are compiled on first use, because most programs are only
+     * ever used with one or two texture types.
+     */
+    std::string vertex_source;
+    std::optional<std::string> fragment_sources[wf::TEXTURE_TYPE_ALL];
+
+    /** Compile the variant for the given type, if it is still pending */
+    void ensure_compiled(int type)
+    {
+        if (fragment_sources[type])
+        {
+            id[type] = compile_program(vertex_source, *fragment_sources[type]);
+            fragment_sources[type].reset();
+        }
+    }
+
     std::map<std::string, int> uniforms[wf::TEXTURE_TYPE_ALL];
 
     /** Find the uniform location for the currently bound program */
@@ -630,14 +902,14 @@ void program_t::compile(const std::string& vertex_source,
 {
     free_resources();
 
+    priv->vertex_source = vertex_source;
     for (const auto& program_type : builtins)
     {
         auto fragment = replace_builtin_with(fragment_source,
             builtin, program_type.second.builtin);
         fragment = replace_builtin_with(fragment,
             builtin_ext, program_type.second.builtin_ext);
-        this->priv->id[program_type.first] =
-            compile_program(vertex_source, fragment);
+        priv->fragment_sources[program_type.first] = fragment;
     }
 }
 
@@ -645,6 +917,9 @@ void program_t::free_resources()
 {
     for (int i = 0; i < wf::TEXTURE_TYPE_ALL; i++)
     {
+        priv->fragment_sources[i].reset();
+        priv->uniforms[i].clear();
+        priv->attribs[i].clear();
         if (this->priv->id[i])
         {
             GL_CALL(glDeleteProgram(priv->id[i]));
@@ -655,6 +930,7 @@ void program_t::free_resources()
 
 void program_t::use(wf::texture_type_t type)
 {
+    priv->ensure_compiled(type);
     if (priv->id[type] == 0)
     {
         throw std::runtime_error("program_t has no program for type " +
@@ -667,6 +943,8 @@ void program_t::use(wf::texture_type_t type)
 
 int program_t::get_program_id(wf::texture_type_t type)
 {
+    priv->ensure_compiled(type);
+
     return priv->id[type];
 }
 
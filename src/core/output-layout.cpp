@@ -960,7 +960,15 @@ class output_layout_t::impl
 
         output_layout = wlr_output_layout_create();
 
-        on_config_reload = [=] (void*) { reconfigure_from_config(); };
+        on_config_reload = [=] (signal_data_t *data)
+        {
+            /* Avoid probing the outputs again if nothing has changed */
+            auto ev = static_cast<reload_config_signal*>(data);
+            if (!ev || ev->section_prefix_changed("output:"))
+            {
+                reconfigure_from_config();
+            }
+        };
         get_core().connect_signal("reload-config", &on_config_reload);
         on_shutdown = [=] (void*)
         {
@@ -23,9 +23,15 @@ wf::cursor_t::cursor_t(wf::seat_t *seat)
     wlr_cursor_warp(cursor, NULL, cursor->x, cursor->y);
     init_xcursor();
 
-    config_reloaded = [=] (wf::signal_data_t*)
+    config_reloaded = [=] (wf::signal_data_t *data)
     {
-        init_xcursor();
+        /* Reloading cursor themes is expensive, avoid it when possible */
+        auto ev = static_cast<wf::reload_config_signal*>(data);
+        if (!ev || ev->option_changed("input/cursor_theme") ||
+            ev->option_changed("input/cursor_size"))
+        {
+            init_xcursor();
+        }
     };
 
     wf::get_core().connect_signal("reload-config", &config_reloaded);
@@ -61,6 +67,8 @@ void wf::cursor_t::setup_listeners()
         set_touchscreen_mode(false); \
         auto ev = static_cast<wlr_event_pointer_ ## evname*>(data); \
         emit_device_event_signal("pointer_" #evname, ev); \
+        core.input->note_input_event(core.input->last_pointer_event, \
+            ev->time_msec); \
         seat->lpointer->handle_pointer_ ## evname(ev); \
         wlr_idle_notify_activity(core.protocols.idle, core.get_current_seat()); \
         emit_device_event_signal("pointer_" #evname "_post", ev); \
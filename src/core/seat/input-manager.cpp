@@ -130,8 +130,14 @@ wf::input_manager_t::input_manager_t()
     });
     input_device_created.connect(&wf::get_core().backend->events.new_input);
 
-    config_updated = [=] (wf::signal_data_t*)
+    config_updated = [=] (wf::signal_data_t *data)
     {
+        auto ev = static_cast<wf::reload_config_signal*>(data);
+        if (ev && !ev->section_changed("input"))
+        {
+            return;
+        }
+
         for (auto& dev : input_devices)
         {
             dev->update_options();
@@ -190,6 +196,7 @@ bool wf::input_manager_t::grab_input(wf::plugin_grab_interface_t *iface)
 void wf::input_manager_t::ungrab_input()
 {
     active_grab = nullptr;
+    wf::get_core_impl().seat->lpointer->discard_grab_motion();
     if (wf::get_core().get_active_output())
     {
         wf::get_core().set_active_view(
@@ -249,18 +256,22 @@ wf::surface_interface_t*wf::input_manager_t::input_surface_at(
     global.x -= og.x;
     global.y -= og.y;
 
+    wf::surface_interface_t *result = nullptr;
     for (auto& v : output->workspace->get_views_in_layer(wf::VISIBLE_LAYERS))
     {
-        for (auto& view : v->enumerate_views())
+        bool found = !v->for_each_view([&] (wayfire_view view)
         {
             if (!view->minimized && can_focus_surface(view.get()))
             {
-                auto surface = view->map_input_coordinates(global, local);
-                if (surface)
-                {
-                    return surface;
-                }
+                result = view->map_input_coordinates(global, local);
             }
+
+            return result == nullptr;
+        });
+
+        if (found)
+        {
+            return result;
         }
     }
 
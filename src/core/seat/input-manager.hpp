@@ -83,6 +83,27 @@ class input_manager_t
 
     /** @return the bindings for the active output */
     wf::bindings_repository_t& get_active_bindings();
+
+    /**
+     * The timestamp of an input event, together with a sequence number which
+     * allows outputs to find out whether they have seen the event already.
+     */
+    struct input_timestamp_t
+    {
+        uint64_t serial    = 0;
+        uint32_t time_msec = 0;
+    };
+
+    /** The latest keyboard and pointer events, for latency statistics */
+    input_timestamp_t last_keyboard_event;
+    input_timestamp_t last_pointer_event;
+
+    /** Record the timestamp of a new input event */
+    void note_input_event(input_timestamp_t& last, uint32_t time_msec)
+    {
+        ++last.serial;
+        last.time_msec = time_msec;
+    }
 };
 }
 
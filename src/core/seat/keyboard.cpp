@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <vector>
 #include <linux/input-event-codes.h>
 #include <xkbcommon/xkbcommon.h>
 
@@ -26,6 +29,9 @@ void wf::keyboard_t::setup_listeners()
         auto ev = static_cast<wlr_event_keyboard_key*>(data);
         emit_device_event_signal("keyboard_key", ev);
 
+        auto& input = wf::get_core_impl().input;
+        input->note_input_event(input->last_keyboard_event, ev->time_msec);
+
         auto& seat = wf::get_core_impl().seat;
         seat->set_keyboard(this);
 
@@ -85,6 +91,103 @@ uint32_t wf::keyboard_t::get_modifiers()
     return wlr_keyboard_get_modifiers(handle);
 }
 
+namespace
+{
+/**
+ * Compiling a keymap takes a lot of time, and usually all keyboards use the
+ * same configuration. So, compiled keymaps are shared between all keyboards,
+ * including virtual keyboards which come and go.
+ */
+class keymap_cache_t
+{
+  public:
+    /** rules, model, layout, variant, options */
+    using names_t = std::array<std::string, 5>;
+
+    ~keymap_cache_t()
+    {
+        for (auto& entry : entries)
+        {
+            xkb_keymap_unref(entry.second);
+        }
+
+        if (context)
+        {
+            xkb_context_unref(context);
+        }
+    }
+
+    /**
+     * Find or compile the keymap for the given names.
+     *
+     * @return A new reference to the keymap.
+     */
+    xkb_keymap *get(const names_t& names)
+    {
+        auto it = std::find_if(entries.begin(), entries.end(),
+            [&] (const auto& entry) { return entry.first == names; });
+        if (it != entries.end())
+        {
+            /* Keep recently used keymaps at the front */
+            std::rotate(entries.begin(), it, it + 1);
+
+            return xkb_keymap_ref(entries.front().second);
+        }
+
+        if (!context)
+        {
+            context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+        }
+
+        auto keymap = compile(names);
+        if (entries.size() >= MAX_ENTRIES)
+        {
+            xkb_keymap_unref(entries.back().second);
+            entries.pop_back();
+        }
+
+        entries.insert(entries.begin(), {names, keymap});
+
+        return xkb_keymap_ref(keymap);
+    }
+
+  private:
+    static constexpr size_t MAX_ENTRIES = 4;
+
+    xkb_context *context = nullptr;
+    std::vector<std::pair<names_t, xkb_keymap*>> entries;
+
+    xkb_keymap *compile(const names_t& names)
+    {
+        xkb_rule_names rule_names;
+        rule_names.rules   = names[0].c_str();
+        rule_names.model   = names[1].c_str();
+        rule_names.layout  = names[2].c_str();
+        rule_names.variant = names[3].c_str();
+        rule_names.options = names[4].c_str();
+        auto keymap = xkb_map_new_from_names(context, &rule_names,
+            XKB_KEYMAP_COMPILE_NO_FLAGS);
+
+        if (!keymap)
+        {
+            LOGE("Could not create keymap with given configuration:",
+                " rules=\"", names[0], "\" model=\"", names[1],
+                "\" layout=\"", names[2], "\" variant=\"", names[3],
+                "\" options=\"", names[4], "\"");
+
+            // reset to NULL
+            std::memset(&rule_names, 0, sizeof(rule_names));
+            keymap = xkb_map_new_from_names(context, &rule_names,
+                XKB_KEYMAP_COMPILE_NO_FLAGS);
+        }
+
+        return keymap;
+    }
+};
+
+keymap_cache_t keymap_cache;
+}
+
 static void set_locked_mod(xkb_mod_mask_t *mods, xkb_keymap *keymap, const char *mod)
 {
     xkb_mod_index_t mod_index = xkb_map_mod_get_index(keymap, mod);
@@ -103,35 +206,7 @@ void wf::keyboard_t::reload_input_options()
 
     this->dirty_options = false;
 
-    auto ctx = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-
-    /* Copy memory to stack, so that .c_str() is valid */
-    std::string rules   = this->rules;
-    std::string model   = this->model;
-    std::string layout  = this->layout;
-    std::string variant = this->variant;
-    std::string options = this->options;
-
-    xkb_rule_names names;
-    names.rules   = rules.c_str();
-    names.model   = model.c_str();
-    names.layout  = layout.c_str();
-    names.variant = variant.c_str();
-    names.options = options.c_str();
-    auto keymap = xkb_map_new_from_names(ctx, &names,
-        XKB_KEYMAP_COMPILE_NO_FLAGS);
-
-    if (!keymap)
-    {
-        LOGE("Could not create keymap with given configuration:",
-            " rules=\"", rules, "\" model=\"", model, "\" layout=\"", layout,
-            "\" variant=\"", variant, "\" options=\"", options, "\"");
-
-        // reset to NULL
-        std::memset(&names, 0, sizeof(names));
-        keymap = xkb_map_new_from_names(ctx, &names, XKB_KEYMAP_COMPILE_NO_FLAGS);
-    }
-
+    auto keymap = keymap_cache.get({rules, model, layout, variant, options});
     xkb_mod_mask_t locked_mods = 0;
 
     if (wf::get_core_impl().input->locked_mods & KB_MOD_NUM_LOCK)
@@ -146,7 +221,6 @@ void wf::keyboard_t::reload_input_options()
 
     wlr_keyboard_set_keymap(handle, keymap);
     xkb_keymap_unref(keymap);
-    xkb_context_unref(ctx);
 
     wlr_keyboard_set_repeat_info(handle, repeat_rate, repeat_delay);
 
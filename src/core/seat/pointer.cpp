@@ -5,6 +5,7 @@
 #include "wayfire/signal-definitions.hpp"
 
 #include <wayfire/util/log.hpp>
+#include <wayfire/debug.hpp>
 #include <wayfire/core.hpp>
 #include <wayfire/output-layout.hpp>
 #include <wayfire/compositor-surface.hpp>
@@ -31,6 +32,8 @@ wf::pointer_t::pointer_t(nonstd::observer_ptr<wf::input_manager_t> input,
     };
     wf::get_core().connect_signal("output-stack-order-changed", &on_views_updated);
     wf::get_core().connect_signal("view-geometry-changed", &on_views_updated);
+
+    on_frame_grab_motion = [=] () { flush_grab_motion(); };
 }
 
 wf::pointer_t::~pointer_t()
@@ -117,7 +120,7 @@ void wf::pointer_t::update_cursor_focus(
     bool focus_change = (cursor_focus != focus);
     if (focus_change)
     {
-        LOGD("change cursor focus ", cursor_focus, " -> ", focus);
+        LOGC(INPUT, "change cursor focus ", cursor_focus, " -> ", focus);
     }
 
     /* Send leave to old focus if compositor surface */
@@ -185,14 +188,19 @@ wf::pointf_t wf::pointer_t::get_absolute_position_from_relative(
     auto output_geometry = view->get_output_geometry();
     wf::point_t origin   = {output_geometry.x, output_geometry.y};
 
-    for (auto& surf : view->enumerate_surfaces(origin))
+    view->for_each_surface([&] (wf::surface_interface_t *surface,
+                                wf::point_t position)
     {
-        if (surf.surface == this->cursor_focus)
+        if (surface == this->cursor_focus)
         {
-            relative.x += surf.position.x;
-            relative.y += surf.position.y;
+            relative.x += position.x;
+            relative.y += position.y;
+
+            return false;
         }
-    }
+
+        return true;
+    }, origin);
 
     relative = view->transform_point(relative);
     auto output = view->get_output()->get_layout_geometry();
@@ -368,7 +376,9 @@ void wf::pointer_t::send_button(wlr_event_pointer_button *ev, bool has_binding)
 {
     if (input->active_grab)
     {
-        if (input->active_grab->callbacks.pointer.button)
+        /* The grab should see the final position before the button */
+        flush_grab_motion();
+        if (input->active_grab && input->active_grab->callbacks.pointer.button)
         {
             input->active_grab->callbacks.pointer.button(ev->button, ev->state);
         }
@@ -394,11 +404,14 @@ void wf::pointer_t::send_button(wlr_event_pointer_button *ev, bool has_binding)
 
 void wf::pointer_t::send_motion(uint32_t time_msec, wf::pointf_t local)
 {
-    if (input->input_grabbed())
+    if (input->input_grabbed() && input->active_grab->callbacks.pointer.motion)
     {
-        auto oc = wf::get_core().get_active_output()->get_cursor_position();
-        if (input->active_grab->callbacks.pointer.motion)
+        if (input->active_grab->coalesce_pointer_motion)
+        {
+            schedule_grab_motion();
+        } else
         {
+            auto oc = wf::get_core().get_active_output()->get_cursor_position();
             input->active_grab->callbacks.pointer.motion(oc.x, oc.y);
         }
     }
@@ -415,6 +428,44 @@ void wf::pointer_t::send_motion(uint32_t time_msec, wf::pointf_t local)
     }
 }
 
+void wf::pointer_t::schedule_grab_motion()
+{
+    if (grab_motion_output)
+    {
+        /* Already scheduled, the latest position is used anyway */
+        return;
+    }
+
+    grab_motion_output = input->active_grab->output;
+    grab_motion_output->render->add_effect(&on_frame_grab_motion,
+        wf::OUTPUT_EFFECT_PRE);
+    grab_motion_output->render->schedule_redraw();
+}
+
+void wf::pointer_t::flush_grab_motion()
+{
+    if (!grab_motion_output)
+    {
+        return;
+    }
+
+    discard_grab_motion();
+    if (input->input_grabbed() && input->active_grab->callbacks.pointer.motion)
+    {
+        auto oc = wf::get_core().get_active_output()->get_cursor_position();
+        input->active_grab->callbacks.pointer.motion(oc.x, oc.y);
+    }
+}
+
+void wf::pointer_t::discard_grab_motion()
+{
+    if (grab_motion_output)
+    {
+        grab_motion_output->render->rem_effect(&on_frame_grab_motion);
+        grab_motion_output = nullptr;
+    }
+}
+
 void wf::pointer_t::handle_pointer_motion(wlr_event_pointer_motion *ev)
 {
     if (input->input_grabbed() &&
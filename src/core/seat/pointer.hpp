@@ -6,6 +6,7 @@
 #include <wayfire/surface.hpp>
 #include <wayfire/util.hpp>
 #include <wayfire/option-wrapper.hpp>
+#include <wayfire/render-manager.hpp>
 #include "surface-map-state.hpp"
 #include <wayfire/nonstd/wlroots-full.hpp>
 
@@ -144,6 +145,23 @@ class pointer_t
      * focus
      */
     void send_motion(uint32_t time_msec, wf::pointf_t local);
+
+    /**
+     * The output where coalesced motion for the active grab is pending,
+     * or null if there is no pending motion.
+     */
+    wf::output_t *grab_motion_output = nullptr;
+    wf::effect_hook_t on_frame_grab_motion;
+
+    /** Deliver the motion to the active grab on the next frame */
+    void schedule_grab_motion();
+
+  public:
+    /** Deliver pending coalesced motion to the active grab, if any */
+    void flush_grab_motion();
+
+    /** Drop pending coalesced motion, for ex. because the grab ended */
+    void discard_grab_motion();
 };
 }
 
@@ -10,12 +10,13 @@
 
 #include "debug-func.hpp"
 #include "main.hpp"
-#include "wayfire/nonstd/safe-list.hpp"
 #include <wayfire/config/file.hpp>
 
 #include <wayland-server.h>
 
 #include "core/core-impl.hpp"
+#include "core/async-log.hpp"
+#include "core/input-replay.hpp"
 #include "wayfire/output.hpp"
 
 wf_runtime_config runtime_config;
@@ -25,6 +26,16 @@ static char buf[INOT_BUF_SIZE];
 
 static std::string config_dir, config_file;
 
+/** Log messages are written from a background thread */
+static wf::async_log_t *async_log = nullptr;
+
+/**
+ * Editors often generate several inotify events for a single save, so the
+ * config file is reloaded only after no events have arrived for this long.
+ */
+static const int CONFIG_RELOAD_DELAY_MS = 100;
+static wl_event_source *config_reload_timer = nullptr;
+
 static void reload_config(int fd)
 {
     wf::config::load_configuration_options_from_file(
@@ -33,15 +44,79 @@ static void reload_config(int fd)
     inotify_add_watch(fd, config_file.c_str(), IN_MODIFY);
 }
 
-static int handle_config_updated(int fd, uint32_t mask, void *data)
+/** Map each option (section/option) to its value */
+static std::map<std::string, std::string> snapshot_config()
 {
-    LOGD("Reloading configuration file");
+    std::map<std::string, std::string> snapshot;
+    for (auto& section : wf::get_core().config.get_all_sections())
+    {
+        for (auto& option : section->get_registered_options())
+        {
+            snapshot[section->get_name() + "/" + option->get_name()] =
+                option->get_value_str();
+        }
+    }
 
-    /* read, but don't use */
-    read(fd, buf, INOT_BUF_SIZE);
+    return snapshot;
+}
+
+/** Fill in the options which differ between the two snapshots */
+static void diff_config(const std::map<std::string, std::string>& before,
+    const std::map<std::string, std::string>& after,
+    wf::reload_config_signal& result)
+{
+    auto mark_changed = [&] (const std::string& name)
+    {
+        result.changed_options.insert(name);
+        result.changed_sections.insert(name.substr(0, name.find('/')));
+    };
+
+    for (auto& [name, value] : before)
+    {
+        auto it = after.find(name);
+        if ((it == after.end()) || (it->second != value))
+        {
+            mark_changed(name);
+        }
+    }
+
+    for (auto& [name, value] : after)
+    {
+        if (!before.count(name))
+        {
+            mark_changed(name);
+        }
+    }
+}
+
+static int handle_config_reload_timeout(void *data)
+{
+    int fd = (intptr_t)data;
+
+    auto before = snapshot_config();
     reload_config(fd);
 
-    wf::get_core().emit_signal("reload-config", nullptr);
+    wf::reload_config_signal ev;
+    diff_config(before, snapshot_config(), ev);
+    if (ev.changed_options.empty())
+    {
+        LOGD("Configuration file reloaded, no options changed");
+
+        return 0;
+    }
+
+    LOGD("Configuration file reloaded, ", ev.changed_options.size(),
+        " option(s) changed");
+    wf::get_core().emit_signal("reload-config", &ev);
+
+    return 0;
+}
+
+static int handle_config_updated(int fd, uint32_t mask, void *data)
+{
+    /* read, but don't use */
+    read(fd, buf, INOT_BUF_SIZE);
+    wl_event_source_timer_update(config_reload_timer, CONFIG_RELOAD_DELAY_MS);
 
     return 0;
 }
@@ -59,10 +134,19 @@ static void print_help()
     std::cout << " -c,  --config            specify config file to use" << std::endl;
     std::cout << " -h,  --help              print this help" << std::endl;
     std::cout << " -d,  --debug             enable debug logging" << std::endl;
+    std::cout <<
+        " -l,  --log-categories    comma-separated debug categories to enable: " <<
+        "all (default), wlr, views, input, render, xwl, plugins" << std::endl;
     std::cout <<
         " -D,  --damage-debug      enable additional debug for damaged regions" <<
         std::endl;
     std::cout << " -R,  --damage-rerender   rerender damaged regions" << std::endl;
+    std::cout << "      --record-input FILE record input events to FILE" <<
+        std::endl;
+    std::cout << "      --replay-input FILE replay input events recorded in FILE" <<
+        std::endl;
+    std::cout << "      --replay-speed X    replay input X times faster" <<
+        std::endl;
     std::cout << " -v,  --version           print version and exit" << std::endl;
     exit(0);
 }
@@ -136,19 +220,6 @@ wlr_renderer *add_egl_depth_renderer(wlr_egl *egl, EGLenum platform,
     return renderer;
 }
 
-namespace wf
-{
-namespace _safe_list_detail
-{
-wl_event_loop *event_loop;
-void idle_cleanup_func(void *data)
-{
-    auto priv = reinterpret_cast<std::function<void()>*>(data);
-    (*priv)();
-}
-}
-}
-
 static bool drop_permissions(void)
 {
     if ((getuid() != geteuid()) || (getgid() != getegid()))
@@ -182,6 +253,13 @@ static wf::log::color_mode_t detect_color_mode()
 static void wlr_log_handler(wlr_log_importance level,
     const char *fmt, va_list args)
 {
+    /* Skip formatting messages which would not be printed anyway */
+    if ((level == WLR_DEBUG) &&
+        !wf::log::enabled_categories[(size_t)wf::log::logging_category::WLR])
+    {
+        return;
+    }
+
     const int bufsize = 4 * 1024;
     char buffer[bufsize];
     vsnprintf(buffer, bufsize, fmt, args);
@@ -230,7 +308,17 @@ static void signal_handler(int signal)
         error = "Unknown";
     }
 
+    if (async_log)
+    {
+        /* Write out everything logged until now, and the trace directly.
+         * This has to happen before logging anything else, because the
+         * crashed thread might hold the producer lock of the buffer, which
+         * synchronous writes do not take. */
+        async_log->flush_from_signal();
+    }
+
     LOGE("Fatal error: ", error);
+
     wf::print_trace(false);
     std::_Exit(-1);
 }
@@ -262,20 +350,36 @@ int main(int argc, char *argv[])
     config_file = config_dir + "/wayfire.ini";
 
     wf::log::log_level_t log_level = wf::log::LOG_LEVEL_INFO;
+    std::string log_categories = "all";
+    std::string record_input_file, replay_input_file;
+    double replay_speed = 1.0;
+
+    /* Options without a short form */
+    enum
+    {
+        OPT_RECORD_INPUT = 256,
+        OPT_REPLAY_INPUT,
+        OPT_REPLAY_SPEED,
+    };
+
     struct option opts[] = {
         {
             "config", required_argument, NULL, 'c'
         },
         {"debug", no_argument, NULL, 'd'},
+        {"log-categories", required_argument, NULL, 'l'},
         {"damage-debug", no_argument, NULL, 'D'},
         {"damage-rerender", no_argument, NULL, 'R'},
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
+        {"record-input", required_argument, NULL, OPT_RECORD_INPUT},
+        {"replay-input", required_argument, NULL, OPT_REPLAY_INPUT},
+        {"replay-speed", required_argument, NULL, OPT_REPLAY_SPEED},
         {0, 0, NULL, 0}
     };
 
     int c, i;
-    while ((c = getopt_long(argc, argv, "c:dDhRv", opts, &i)) != -1)
+    while ((c = getopt_long(argc, argv, "c:dDhl:Rv", opts, &i)) != -1)
     {
         switch (c)
         {
@@ -299,20 +403,56 @@ int main(int argc, char *argv[])
             log_level = wf::log::LOG_LEVEL_DEBUG;
             break;
 
+          case 'l':
+            log_categories = optarg;
+            break;
+
           case 'v':
             print_version();
             break;
 
+          case OPT_RECORD_INPUT:
+            record_input_file = optarg;
+            break;
+
+          case OPT_REPLAY_INPUT:
+            replay_input_file = optarg;
+            break;
+
+          case OPT_REPLAY_SPEED:
+            replay_speed = std::atof(optarg);
+            break;
+
           default:
             std::cerr << "Unrecognized command line argument " << optarg << "\n" <<
                 std::endl;
         }
     }
 
+    if (!wf::log::parse_categories(log_categories,
+        wf::log::enabled_categories))
+    {
+        std::cerr << "Invalid log categories " << log_categories << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (log_level != wf::log::LOG_LEVEL_DEBUG)
+    {
+        wf::log::enabled_categories.reset();
+    }
+
+    /* The stream and its buffer are intentionally never destroyed, as
+     * messages can be logged until the very end. At exit, the buffer switches
+     * to synchronous writes. */
+    std::cout.flush();
+    async_log = new wf::async_log_t(STDOUT_FILENO);
+    auto log_stream = new std::ostream(async_log);
+    std::atexit([] () { async_log->stop(); });
+
     auto wlr_log_level =
         (log_level == wf::log::LOG_LEVEL_DEBUG ? WLR_DEBUG : WLR_ERROR);
     wlr_log_init(wlr_log_level, wlr_log_handler);
-    wf::log::initialize_logging(std::cout, log_level, detect_color_mode());
+    wf::log::initialize_logging(*log_stream, log_level, detect_color_mode());
 
 #ifndef ASAN_ENABLED
     /* In case of crash, print the stacktrace for debugging.
@@ -323,10 +463,7 @@ int main(int argc, char *argv[])
 #endif
 
     LOGI("Starting wayfire version ", WAYFIRE_VERSION);
-    /* First create display and initialize safe-list's event loop, so that
-     * wf objects (which depend on safe-list) can work */
     auto display = wl_display_create();
-    wf::_safe_list_detail::event_loop = wl_display_get_event_loop(display);
 
     auto& core = wf::get_core_impl();
 
@@ -368,6 +505,8 @@ int main(int argc, char *argv[])
 
     wl_event_loop_add_fd(core.ev_loop, inotify_fd, WL_EVENT_READABLE,
         handle_config_updated, NULL);
+    config_reload_timer = wl_event_loop_add_timer(core.ev_loop,
+        handle_config_reload_timeout, (void*)(intptr_t)inotify_fd);
     core.init();
 
     auto socket = choose_socket(core.display);
@@ -380,6 +519,20 @@ int main(int argc, char *argv[])
 
     core.wayland_display = socket.value();
     LOGI("Using socket name ", core.wayland_display);
+
+    /* The virtual input devices need a backend which is started with the
+     * others */
+    std::unique_ptr<wf::input_replay_t> input_replay;
+    if (!replay_input_file.empty())
+    {
+        input_replay = std::make_unique<wf::input_replay_t>(
+            replay_input_file, replay_speed);
+        if (!input_replay->is_valid())
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
     if (!wlr_backend_start(core.backend))
     {
         LOGE("Failed to initialize backend, exiting");
@@ -391,9 +544,23 @@ int main(int argc, char *argv[])
 
     core.post_init();
     setenv("WAYLAND_DISPLAY", core.wayland_display.c_str(), 1);
+
+    std::unique_ptr<wf::input_recorder_t> input_recorder;
+    if (!record_input_file.empty())
+    {
+        input_recorder = std::make_unique<wf::input_recorder_t>(record_input_file);
+    }
+
+    if (input_replay)
+    {
+        input_replay->start();
+    }
+
     wl_display_run(core.display);
 
     /* Teardown */
+    input_recorder.reset();
+    input_replay.reset();
     wl_display_destroy_clients(core.display);
     wl_display_destroy(core.display);
 
@@ -0,0 +1,97 @@
+#include <wayfire/frame-stats.hpp>
+#include <algorithm>
+#include <cmath>
+
+static size_t bucket_for(int64_t usec)
+{
+    int64_t bucket = std::max<int64_t>(usec, 0) / wf::frame_histogram_t::BUCKET_USEC;
+
+    return std::min<size_t>(bucket, wf::frame_histogram_t::NUM_BUCKETS - 1);
+}
+
+void wf::frame_histogram_t::add_sample(int64_t usec)
+{
+    if (count == WINDOW)
+    {
+        /* next points to the oldest sample */
+        --buckets[bucket_for(samples[next])];
+        sum -= samples[next];
+    } else
+    {
+        ++count;
+    }
+
+    samples[next] = usec;
+    ++buckets[bucket_for(usec)];
+    sum += usec;
+    next = (next + 1) % WINDOW;
+}
+
+size_t wf::frame_histogram_t::size() const
+{
+    return count;
+}
+
+int64_t wf::frame_histogram_t::last() const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    return samples[(next + WINDOW - 1) % WINDOW];
+}
+
+int64_t wf::frame_histogram_t::mean() const
+{
+    return count ? sum / (int64_t)count : 0;
+}
+
+int64_t wf::frame_histogram_t::max() const
+{
+    int64_t result = 0;
+    for_each_sample([&] (int64_t sample)
+    {
+        result = std::max(result, sample);
+    });
+
+    return result;
+}
+
+int64_t wf::frame_histogram_t::percentile(double p) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    p = std::clamp(p, 0.0, 1.0);
+    size_t rank = std::max<size_t>(1, std::ceil(p * count));
+    size_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            return (i + 1) * BUCKET_USEC;
+        }
+    }
+
+    return NUM_BUCKETS * BUCKET_USEC;
+}
+
+void wf::frame_histogram_t::for_each_sample(
+    wf::function_ref<void(int64_t)> func) const
+{
+    size_t oldest = (next + WINDOW - count) % WINDOW;
+    for (size_t i = 0; i < count; i++)
+    {
+        func(samples[(oldest + i) % WINDOW]);
+    }
+}
+
+const std::array<uint32_t, wf::frame_histogram_t::NUM_BUCKETS>&
+wf::frame_histogram_t::get_buckets() const
+{
+    return buckets;
+}
@@ -10,6 +10,7 @@
 #include "../core/seat/input-manager.hpp"
 #include "../view/xdg-shell.hpp"
 #include <wayfire/util/log.hpp>
+#include <wayfire/debug.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 
 #include <algorithm>
@@ -381,11 +382,12 @@ bool wf::output_impl_t::activate_plugin(const plugin_grab_interface_uptr& owner,
 
     if (active_plugins.find(owner.get()) != active_plugins.end())
     {
-        LOGD("output ", handle->name,
+        LOGC(PLUGINS, "output ", handle->name,
             ": activate plugin ", owner->name, " again");
     } else
     {
-        LOGD("output ", handle->name, ": activate plugin ", owner->name);
+        LOGC(PLUGINS, "output ", handle->name, ": activate plugin ",
+            owner->name);
     }
 
     active_plugins.insert(owner.get());
@@ -403,7 +405,8 @@ bool wf::output_impl_t::deactivate_plugin(
     }
 
     active_plugins.erase(it);
-    LOGD("output ", handle->name, ": deactivate plugin ", owner->name);
+    LOGC(PLUGINS, "output ", handle->name, ": deactivate plugin ",
+        owner->name);
 
     if (active_plugins.count(owner.get()) == 0)
     {
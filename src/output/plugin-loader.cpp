@@ -3,7 +3,11 @@
 #include <set>
 #include <memory>
 #include <filesystem>
+#include <chrono>
+#include <iterator>
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "plugin-loader.hpp"
 #include "wayfire/output-layout.hpp"
@@ -11,6 +15,7 @@
 #include "../core/wm.hpp"
 #include "wayfire/core.hpp"
 #include <wayfire/util/log.hpp>
+#include <wayfire/debug.hpp>
 
 namespace
 {
@@ -26,12 +31,61 @@ B union_cast(A object)
 
     return helper.y;
 }
+
+using steady_clock = std::chrono::steady_clock;
+
+double get_elapsed_ms(steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(
+        steady_clock::now() - since).count();
+}
+
+/** @return The name of the plugin as used in the config, i.e libNAME.so */
+std::string get_plugin_name(const std::string& path)
+{
+    auto name = std::filesystem::path(path).stem().string();
+    if (name.rfind("lib", 0) == 0)
+    {
+        name = name.substr(3);
+    }
+
+    return name;
+}
+
+/**
+ * Ask the kernel to read the plugin files in the background, so that disk
+ * I/O for all plugins overlaps instead of happening in each dlopen().
+ */
+void prefetch_plugin_files(const std::vector<std::string>& paths)
+{
+    for (auto& path : paths)
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            close(fd);
+        }
+    }
+}
 }
 
 plugin_manager::plugin_manager(wf::output_t *o)
 {
     this->output = o;
     this->plugins_opt.load_option("core/plugins");
+    this->deferred_plugins_opt.load_option("core/deferred_plugins");
+
+    on_first_frame = [=] ()
+    {
+        idle_init_deferred.run_once([=] ()
+        {
+            output->render->rem_effect(&on_first_frame);
+            first_frame_rendered = true;
+            init_deferred_plugins();
+        });
+    };
+    output->render->add_effect(&on_first_frame, wf::OUTPUT_EFFECT_POST);
 
     reload_dynamic_plugins();
     load_static_plugins();
@@ -61,6 +115,8 @@ void plugin_manager::deinit_plugins(bool unloadable)
 
 plugin_manager::~plugin_manager()
 {
+    output->render->rem_effect(&on_first_frame);
+
     /* First remove unloadable plugins, then others */
     deinit_plugins(true);
     deinit_plugins(false);
@@ -77,10 +133,14 @@ void plugin_manager::init_plugin(wayfire_plugin& p)
 
 void plugin_manager::destroy_plugin(wayfire_plugin& p)
 {
-    p->fini();
+    /* Deferred plugins might not have been initialized yet */
+    if (p->grab_interface)
+    {
+        p->fini();
 
-    p->grab_interface->ungrab();
-    output->deactivate_plugin(p->grab_interface);
+        p->grab_interface->ungrab();
+        output->deactivate_plugin(p->grab_interface);
+    }
 
     auto handle = p->handle;
     p.reset();
@@ -138,7 +198,7 @@ wayfire_plugin plugin_manager::load_plugin_from_file(std::string path)
         return nullptr;
     }
 
-    LOGD("Loading plugin ", path.c_str());
+    LOGC(PLUGINS, "Loading plugin ", path.c_str());
     auto new_instance_func =
         union_cast<void*, wayfire_plugin_load_func>(new_instance_func_ptr);
 
@@ -213,7 +273,7 @@ void plugin_manager::reload_dynamic_plugins()
             it->first) == next_plugins.end()) &&
             it->second->is_unloadable())
         {
-            LOGD("unload plugin ", it->first.c_str());
+            LOGC(PLUGINS, "unload plugin ", it->first.c_str());
             destroy_plugin(it->second);
             it = loaded_plugins.erase(it);
         } else
@@ -222,21 +282,83 @@ void plugin_manager::reload_dynamic_plugins()
         }
     }
 
+    std::vector<std::string> new_plugins;
+    for (auto& plugin : next_plugins)
+    {
+        if (!loaded_plugins.count(plugin))
+        {
+            new_plugins.push_back(plugin);
+        }
+    }
+
+    prefetch_plugin_files(new_plugins);
+
+    std::stringstream deferred_stream{(std::string)deferred_plugins_opt};
+    std::set<std::string> deferred{std::istream_iterator<std::string>(
+        deferred_stream), std::istream_iterator<std::string>()};
+
     /* load new plugins */
-    for (auto plugin : next_plugins)
+    auto start_time = steady_clock::now();
+    double total_load_ms = 0, total_init_ms = 0;
+    for (auto& plugin : new_plugins)
     {
-        if (loaded_plugins.count(plugin))
+        auto load_start = steady_clock::now();
+        auto ptr = load_plugin_from_file(plugin);
+        double load_ms = get_elapsed_ms(load_start);
+        total_load_ms += load_ms;
+        if (!ptr)
         {
             continue;
         }
 
-        auto ptr = load_plugin_from_file(plugin);
-        if (ptr)
+        if (!first_frame_rendered && deferred.count(get_plugin_name(plugin)))
         {
-            init_plugin(ptr);
+            LOGC(PLUGINS, "Plugin ", plugin, " on output ",
+                output->to_string(), ": dlopen ", load_ms, "ms, init deferred");
             loaded_plugins[plugin] = std::move(ptr);
+            continue;
+        }
+
+        auto init_start = steady_clock::now();
+        init_plugin(ptr);
+        double init_ms = get_elapsed_ms(init_start);
+        total_init_ms += init_ms;
+
+        LOGC(PLUGINS, "Plugin ", plugin, " on output ",
+            output->to_string(), ": dlopen ", load_ms, "ms, init ", init_ms, "ms");
+        loaded_plugins[plugin] = std::move(ptr);
+    }
+
+    if (!new_plugins.empty())
+    {
+        LOGI("Loaded ", new_plugins.size(), " plugins on output ",
+            output->to_string(), " in ", get_elapsed_ms(start_time),
+            "ms (dlopen ", total_load_ms, "ms, init ", total_init_ms, "ms)");
+    }
+}
+
+void plugin_manager::init_deferred_plugins()
+{
+    auto start_time = steady_clock::now();
+    int count = 0;
+    for (auto& [path, plugin] : loaded_plugins)
+    {
+        if (plugin && !plugin->grab_interface)
+        {
+            auto init_start = steady_clock::now();
+            init_plugin(plugin);
+            LOGC(PLUGINS, "Plugin ", path, " on output ",
+                output->to_string(), ": deferred init ",
+                get_elapsed_ms(init_start), "ms");
+            ++count;
         }
     }
+
+    if (count > 0)
+    {
+        LOGI("Initialized ", count, " deferred plugins on output ",
+            output->to_string(), " in ", get_elapsed_ms(start_time), "ms");
+    }
 }
 
 template<class T>
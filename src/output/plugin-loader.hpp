@@ -6,6 +6,7 @@
 #include "wayfire/plugin.hpp"
 #include "config.h"
 #include "wayfire/util.hpp"
+#include "wayfire/render-manager.hpp"
 #include <wayfire/option-wrapper.hpp>
 
 namespace wf
@@ -27,8 +28,19 @@ struct plugin_manager
   private:
     wf::output_t *output;
     wf::option_wrapper_t<std::string> plugins_opt;
+    wf::option_wrapper_t<std::string> deferred_plugins_opt;
     std::unordered_map<std::string, wayfire_plugin> loaded_plugins;
 
+    /**
+     * Plugins listed in core/deferred_plugins are loaded together with the
+     * others, but initialized only after the output has rendered its first
+     * frame, so that they do not delay the first visible frame.
+     */
+    bool first_frame_rendered = false;
+    wf::effect_hook_t on_first_frame;
+    wf::wl_idle_call idle_init_deferred;
+    void init_deferred_plugins();
+
     void deinit_plugins(bool unloadable);
 
     wayfire_plugin load_plugin_from_file(std::string path);
@@ -1,18 +1,29 @@
 #include "wayfire/render-manager.hpp"
 #include "wayfire/signal-definitions.hpp"
 #include "wayfire/workspace-stream.hpp"
+#include "wayfire/frame-stats.hpp"
 #include "wayfire/output.hpp"
 #include "../core/core-impl.hpp"
 #include "wayfire/util.hpp"
 #include "wayfire/workspace-manager.hpp"
 #include "../core/seat/seat.hpp"
+#include "../core/seat/input-manager.hpp"
 #include "../core/opengl-priv.hpp"
+#include "../view/view-impl.hpp"
 #include "../main.hpp"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <optional>
+#include <unordered_set>
 #include <wayfire/nonstd/reverse.hpp>
 #include <wayfire/nonstd/safe-list.hpp>
 #include <wayfire/util/log.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
+#include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
 
 namespace wf
 {
@@ -117,12 +128,14 @@ struct output_damage_t
 
     /**
      * Swap the output buffers. Also clears the scheduled damage.
+     *
+     * @return Whether the new buffer was committed successfully.
      */
-    void swap_buffers(wf::region_t& swap_damage)
+    bool swap_buffers(wf::region_t& swap_damage)
     {
         if (!output)
         {
-            return;
+            return false;
         }
 
         int w, h;
@@ -136,8 +149,10 @@ struct output_damage_t
 
         wlr_output_set_damage(output,
             const_cast<wf::region_t&>(swap_damage).to_pixman());
-        wlr_output_commit(output);
+        bool committed = wlr_output_commit(output);
         frame_damage.clear();
+
+        return committed;
     }
 
     bool force_next_frame = false;
@@ -246,6 +261,461 @@ struct effect_hook_manager_t
     }
 };
 
+/**
+ * Steps all running animations of an output once per frame
+ */
+struct animation_timeline_t
+{
+    wf::safe_list_t<animation_hook_t*> animations;
+
+    void add_animation(animation_hook_t *hook)
+    {
+        animations.remove_all(hook);
+        animations.push_back(hook);
+    }
+
+    void rem_animation(animation_hook_t *hook)
+    {
+        animations.remove_all(hook);
+    }
+
+    /** @return Whether any animations are still running */
+    bool step()
+    {
+        animations.for_each([=] (auto hook)
+        {
+            if (!(*hook)())
+            {
+                animations.remove_all(hook);
+            }
+        });
+
+        return animations.size() > 0;
+    }
+};
+
+/**
+ * Collects frame pacing and latency statistics from the presentation feedback
+ * of an output.
+ */
+struct frame_stats_tracker_t
+{
+    wf::frame_stats_t stats;
+
+    /** A frame which has been committed, but not presented yet */
+    struct frame_t
+    {
+        /* When the frame event which started the repaint arrived */
+        std::optional<timespec> frame_event;
+        timespec repaint_start;
+        /* The latest input events handled before the repaint */
+        std::optional<uint32_t> keyboard_msec;
+        std::optional<uint32_t> pointer_msec;
+        /* The commit sequence number of the output after the commit */
+        uint32_t commit_seq = 0;
+    };
+
+    /* Frames are matched to presentation events by their commit sequence
+     * number. If presentation feedback gets lost, the oldest frames are
+     * dropped eventually. */
+    static constexpr size_t MAX_IN_FLIGHT = 4;
+    std::deque<frame_t> in_flight;
+    frame_t current;
+
+    std::optional<timespec> frame_event;
+    std::optional<timespec> last_present;
+    uint64_t keyboard_serial = 0;
+    uint64_t pointer_serial  = 0;
+
+    static clockid_t get_clock()
+    {
+        return wlr_backend_get_presentation_clock(wf::get_core_impl().backend);
+    }
+
+    static timespec now()
+    {
+        timespec ts;
+        clock_gettime(get_clock(), &ts);
+
+        return ts;
+    }
+
+    static int64_t usec_between(const timespec& from, const timespec& to)
+    {
+        return (to.tv_sec - from.tv_sec) * 1000000ll +
+               (to.tv_nsec - from.tv_nsec) / 1000;
+    }
+
+    /** Take the given input event, if it has not been seen yet */
+    static std::optional<uint32_t> take_input(
+        const wf::input_manager_t::input_timestamp_t& event, uint64_t& seen)
+    {
+        if (event.serial == seen)
+        {
+            return {};
+        }
+
+        seen = event.serial;
+
+        return event.time_msec;
+    }
+
+    /** The output has sent a frame event */
+    void frame_requested()
+    {
+        frame_event = now();
+    }
+
+    /** A repaint which will be committed has started */
+    void repaint_started()
+    {
+        auto& input = wf::get_core_impl().input;
+
+        current = {};
+        current.frame_event   = frame_event;
+        current.repaint_start = now();
+        current.keyboard_msec =
+            take_input(input->last_keyboard_event, keyboard_serial);
+        current.pointer_msec =
+            take_input(input->last_pointer_event, pointer_serial);
+    }
+
+    /**
+     * The repaint which was started last has been committed.
+     *
+     * @param commit_seq The commit sequence number of the output after the
+     *   commit, which is reported again when the frame is presented.
+     */
+    void frame_committed(uint32_t commit_seq)
+    {
+        current.commit_seq = commit_seq;
+        in_flight.push_back(current);
+        if (in_flight.size() > MAX_IN_FLIGHT)
+        {
+            in_flight.pop_front();
+        }
+    }
+
+    /** Add the latency from an input event to presentation */
+    static void add_input_latency(wf::frame_histogram_t& histogram,
+        std::optional<uint32_t> input_msec, const timespec& when)
+    {
+        if (!input_msec || (get_clock() != CLOCK_MONOTONIC))
+        {
+            return;
+        }
+
+        /* Input timestamps are in milliseconds and wrap around */
+        uint32_t when_msec = when.tv_sec * 1000 + when.tv_nsec / 1000000;
+        int32_t latency    = when_msec - *input_msec;
+        if (latency >= 0)
+        {
+            histogram.add_sample(latency * 1000ll);
+        }
+    }
+
+    /**
+     * Update the statistics and fill in the signal data for a presentation.
+     *
+     * @return false if the presented commit was not made by the render
+     *   manager, for ex. a modeset, in which case no statistics are recorded.
+     */
+    bool presented(wlr_output_event_present *ev,
+        wf::frame_presented_signal& data)
+    {
+        /* Frames committed before the presented one will never be presented
+         * themselves, their feedback was lost */
+        while (!in_flight.empty() &&
+               ((int32_t)(in_flight.front().commit_seq - ev->commit_seq) < 0))
+        {
+            in_flight.pop_front();
+        }
+
+        const timespec when = *ev->when;
+        stats.refresh_usec = ev->refresh / 1000;
+        if (in_flight.empty() || (in_flight.front().commit_seq != ev->commit_seq))
+        {
+            /* Still a vblank on which the output was updated */
+            last_present = when;
+
+            return false;
+        }
+
+        frame_t frame = in_flight.front();
+        in_flight.pop_front();
+
+        data.when  = when;
+        data.stats = &stats;
+        ++stats.frames_presented;
+
+        if (last_present)
+        {
+            data.interval_usec = usec_between(*last_present, when);
+
+            /* Only count intervals between frames which were repainted one
+             * after another, not the time the output was idle */
+            bool continuous = (stats.refresh_usec <= 0) ||
+                (frame.frame_event &&
+                    (usec_between(*last_present, *frame.frame_event) <
+                        stats.refresh_usec / 2));
+            if (continuous)
+            {
+                stats.present_interval.add_sample(data.interval_usec);
+            }
+        }
+
+        last_present = when;
+        data.repaint_latency_usec = usec_between(frame.repaint_start, when);
+        stats.repaint_latency.add_sample(data.repaint_latency_usec);
+
+        /* A frame started by a frame event should be presented on the next
+         * vblank. Every vblank after that was missed. */
+        if ((stats.refresh_usec > 0) && frame.frame_event)
+        {
+            double vblanks = 1.0 * usec_between(*frame.frame_event, when) /
+                stats.refresh_usec;
+            data.missed_frames = std::max(0, (int)std::round(vblanks) - 1);
+            stats.missed_frames += data.missed_frames;
+        }
+
+        add_input_latency(stats.keyboard_latency, frame.keyboard_msec, when);
+        add_input_latency(stats.pointer_latency, frame.pointer_msec, when);
+
+        return true;
+    }
+};
+
+/**
+ * Measures the GPU time of parts of a repaint with EXT_disjoint_timer_query.
+ *
+ * Results are read back only once they are available, a few frames later, so
+ * that measuring never stalls the pipeline.
+ */
+struct gpu_timer_t
+{
+    static constexpr int QUERY_FRAMES = 4;
+    static constexpr int QUERIES_PER_FRAME = 2;
+
+    PFNGLGENQUERIESEXTPROC gen_queries;
+    PFNGLDELETEQUERIESEXTPROC delete_queries;
+    PFNGLBEGINQUERYEXTPROC begin_query;
+    PFNGLENDQUERYEXTPROC end_query;
+    PFNGLGETQUERYOBJECTUIVEXTPROC get_query_uiv;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_ui64v;
+
+    bool initialized = false;
+    bool supported   = false;
+
+    GLuint queries[QUERY_FRAMES][QUERIES_PER_FRAME];
+    /* Whether the queries of each frame have been issued, but not read */
+    bool pending[QUERY_FRAMES] = {};
+    /* Number of queries issued for each frame */
+    int issued[QUERY_FRAMES] = {};
+    int current = 0;
+
+    /* Whether the current frame is being measured */
+    bool measuring = false;
+    int64_t last_result = -1;
+
+    /** Load the extension. Needs a current GL context. */
+    void init()
+    {
+        initialized = true;
+        auto extensions = (const char*)glGetString(GL_EXTENSIONS);
+        if (!extensions ||
+            !std::strstr(extensions, "GL_EXT_disjoint_timer_query"))
+        {
+            return;
+        }
+
+        gen_queries = (PFNGLGENQUERIESEXTPROC)
+            eglGetProcAddress("glGenQueriesEXT");
+        delete_queries = (PFNGLDELETEQUERIESEXTPROC)
+            eglGetProcAddress("glDeleteQueriesEXT");
+        begin_query = (PFNGLBEGINQUERYEXTPROC)
+            eglGetProcAddress("glBeginQueryEXT");
+        end_query = (PFNGLENDQUERYEXTPROC)
+            eglGetProcAddress("glEndQueryEXT");
+        get_query_uiv = (PFNGLGETQUERYOBJECTUIVEXTPROC)
+            eglGetProcAddress("glGetQueryObjectuivEXT");
+        get_query_ui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC)
+            eglGetProcAddress("glGetQueryObjectui64vEXT");
+
+        supported = gen_queries && delete_queries && begin_query &&
+            end_query && get_query_uiv && get_query_ui64v;
+        if (supported)
+        {
+            GL_CALL(gen_queries(QUERY_FRAMES * QUERIES_PER_FRAME, &queries[0][0]));
+        }
+    }
+
+    ~gpu_timer_t()
+    {
+        if (supported)
+        {
+            OpenGL::render_begin();
+            GL_CALL(delete_queries(QUERY_FRAMES * QUERIES_PER_FRAME,
+                &queries[0][0]));
+            OpenGL::render_end();
+        }
+    }
+
+    /** Read the results of finished frames. */
+    void collect()
+    {
+        GLint disjoint = 0;
+        GL_CALL(glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint));
+
+        for (int i = 1; i <= QUERY_FRAMES; i++)
+        {
+            /* Go from the oldest frame to the newest */
+            int frame = (current + i) % QUERY_FRAMES;
+            if (!pending[frame])
+            {
+                continue;
+            }
+
+            GLuint available = 0;
+            GL_CALL(get_query_uiv(queries[frame][issued[frame] - 1],
+                GL_QUERY_RESULT_AVAILABLE_EXT, &available));
+            if (!available && !disjoint)
+            {
+                /* Later frames cannot be ready either */
+                break;
+            }
+
+            GLuint64 total = 0;
+            for (int q = 0; q < issued[frame]; q++)
+            {
+                GLuint64 elapsed = 0;
+                GL_CALL(get_query_ui64v(queries[frame][q],
+                    GL_QUERY_RESULT_EXT, &elapsed));
+                total += elapsed;
+            }
+
+            /* Timings are meaningless if the GPU was reset or throttled */
+            if (!disjoint)
+            {
+                last_result = total / 1000;
+            }
+
+            pending[frame] = false;
+        }
+    }
+
+    /** Start measuring a new frame, if the timer is supported. */
+    void begin_frame()
+    {
+        if (!initialized)
+        {
+            init();
+        }
+
+        measuring = false;
+        if (!supported)
+        {
+            return;
+        }
+
+        collect();
+        /* All queries for this slot are still in flight, skip the frame */
+        measuring       = !pending[current];
+        issued[current] = 0;
+    }
+
+    /** Start timing a part of the frame */
+    void begin_part()
+    {
+        if (measuring && (issued[current] < QUERIES_PER_FRAME))
+        {
+            GL_CALL(begin_query(GL_TIME_ELAPSED_EXT,
+                queries[current][issued[current]]));
+        }
+    }
+
+    /** Stop timing the current part of the frame */
+    void end_part()
+    {
+        if (measuring && (issued[current] < QUERIES_PER_FRAME))
+        {
+            GL_CALL(end_query(GL_TIME_ELAPSED_EXT));
+            ++issued[current];
+        }
+    }
+
+    void end_frame()
+    {
+        if (measuring && (issued[current] > 0))
+        {
+            pending[current] = true;
+            current = (current + 1) % QUERY_FRAMES;
+        }
+
+        measuring = false;
+    }
+};
+
+/**
+ * Measures the CPU time and rendering work of the stages of a repaint.
+ */
+struct frame_profiler_t
+{
+    using clock = std::chrono::steady_clock;
+
+    wf::frame_render_stats_t current;
+    wf::frame_render_stats_t last;
+    gpu_timer_t gpu_timer;
+
+    clock::time_point paint_start;
+    clock::time_point stage_start;
+    OpenGL::render_counters_t counters_start;
+
+    static int64_t usec_since(clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            clock::now() - start).count();
+    }
+
+    void begin_frame()
+    {
+        current = {};
+        paint_start    = clock::now();
+        counters_start = OpenGL::get_render_counters();
+    }
+
+    void begin_stage()
+    {
+        stage_start = clock::now();
+    }
+
+    void end_stage(wf::frame_stage_t stage)
+    {
+        current.stage_usec[stage] += usec_since(stage_start);
+    }
+
+    /** Record the area of the region which will be swapped */
+    void set_damage(const wf::region_t& damage)
+    {
+        for (const auto& box : damage)
+        {
+            current.damage_area +=
+                int64_t(box.x2 - box.x1) * int64_t(box.y2 - box.y1);
+        }
+    }
+
+    /** The frame has been committed */
+    void end_frame()
+    {
+        auto& counters = OpenGL::get_render_counters();
+        current.draw_calls    = counters.draw_calls - counters_start.draw_calls;
+        current.render_passes =
+            counters.render_passes - counters_start.render_passes;
+        current.paint_usec = usec_since(paint_start);
+        current.gpu_usec   = gpu_timer.last_result;
+        last = current;
+    }
+};
+
 /**
  * A class to manage and run postprocessing effects
  */
@@ -495,6 +965,9 @@ class wf::render_manager::impl
     wf::region_t swap_damage;
     std::unique_ptr<output_damage_t> output_damage;
     std::unique_ptr<effect_hook_manager_t> effects;
+    std::unique_ptr<animation_timeline_t> timeline;
+    std::unique_ptr<frame_stats_tracker_t> frame_stats;
+    std::unique_ptr<frame_profiler_t> profiler;
     std::unique_ptr<postprocessing_manager_t> postprocessing;
     std::unique_ptr<depth_buffer_manager_t> depth_buffer_manager;
 
@@ -506,6 +979,9 @@ class wf::render_manager::impl
     {
         output_damage = std::make_unique<output_damage_t>(o);
         effects = std::make_unique<effect_hook_manager_t>();
+        timeline = std::make_unique<animation_timeline_t>();
+        frame_stats = std::make_unique<frame_stats_tracker_t>();
+        profiler    = std::make_unique<frame_profiler_t>();
         postprocessing = std::make_unique<postprocessing_manager_t>(o);
         depth_buffer_manager = std::make_unique<depth_buffer_manager_t>();
 
@@ -513,12 +989,21 @@ class wf::render_manager::impl
         {
             auto ev = static_cast<wlr_output_event_present*>(data);
             this->refresh_nsec = ev->refresh;
+
+            wf::frame_presented_signal presented;
+            presented.output = output;
+            if (frame_stats->presented(ev, presented))
+            {
+                output->render->emit_signal("frame-presented", &presented);
+            }
         });
         on_present.connect(&output->handle->events.present);
 
         max_render_time_opt.load_option("core/max_render_time");
         on_frame.set_callback([&] (void*)
         {
+            frame_stats->frame_requested();
+
             /*
              * Leave a bit of time for clients to render, see
              * https://github.com/swaywm/sway/pull/4588
@@ -721,9 +1206,23 @@ class wf::render_manager::impl
      */
     void paint()
     {
-        /* Part 1: frame setup: query damage, etc. */
+        clear_occlusion();
+        profiler->begin_frame();
+
+        /* Part 1: frame setup: step animations, query damage, etc. */
+        if (timeline->step())
+        {
+            /* Keep frames coming, but repaint only if something is damaged */
+            wlr_output_schedule_frame(output->handle);
+        }
+
+        profiler->begin_stage();
         effects->run_effects(OUTPUT_EFFECT_PRE);
+        profiler->end_stage(wf::FRAME_STAGE_PRE);
+
+        profiler->begin_stage();
         effects->run_effects(OUTPUT_EFFECT_DAMAGE);
+        profiler->end_stage(wf::FRAME_STAGE_DAMAGE);
 
         bool needs_swap;
         if (!output_damage->make_current(needs_swap))
@@ -744,13 +1243,20 @@ class wf::render_manager::impl
             return;
         }
 
+        frame_stats->repaint_started();
         update_bound_output();
+        profiler->gpu_timer.begin_frame();
 
         /* Part 2: call the renderer, which sets swap_damage and
          * draws the scenegraph */
+        profiler->begin_stage();
+        profiler->gpu_timer.begin_part();
         render_output();
+        profiler->gpu_timer.end_part();
+        profiler->end_stage(wf::FRAME_STAGE_RENDER);
 
         /* Part 3: finalize the scene: overlay effects and sw cursors */
+        profiler->begin_stage();
         effects->run_effects(OUTPUT_EFFECT_OVERLAY);
 
         if (postprocessing->post_effects.size())
@@ -761,8 +1267,11 @@ class wf::render_manager::impl
         OpenGL::render_begin(postprocessing->get_target_framebuffer());
         wlr_output_render_software_cursors(output->handle, swap_damage.to_pixman());
         OpenGL::render_end();
+        profiler->end_stage(wf::FRAME_STAGE_OVERLAY);
 
         /* Part 4: postprocessing effects */
+        profiler->begin_stage();
+        profiler->gpu_timer.begin_part();
         postprocessing->run_post_effects();
         if (output_inhibit_counter)
         {
@@ -772,11 +1281,26 @@ class wf::render_manager::impl
             OpenGL::render_end();
         }
 
+        profiler->gpu_timer.end_part();
+        profiler->gpu_timer.end_frame();
+        profiler->end_stage(wf::FRAME_STAGE_POSTPROCESS);
+
         /* Part 5: finalize frame: swap buffers, send frame_done, etc */
         OpenGL::unbind_output(output);
-        output_damage->swap_buffers(swap_damage);
+        profiler->set_damage(swap_damage);
+        bool committed = output_damage->swap_buffers(swap_damage);
+        if (committed)
+        {
+            frame_stats->frame_committed(output->handle->commit_seq);
+        }
+
         swap_damage.clear();
         post_paint();
+
+        if (committed)
+        {
+            profiler->end_frame();
+        }
     }
 
     /**
@@ -784,7 +1308,9 @@ class wf::render_manager::impl
      */
     void post_paint()
     {
+        profiler->begin_stage();
         effects->run_effects(OUTPUT_EFFECT_POST);
+        profiler->end_stage(wf::FRAME_STAGE_POST);
 
         if (constant_redraw_counter)
         {
@@ -792,13 +1318,216 @@ class wf::render_manager::impl
         }
     }
 
+    /**
+     * Check whether the view can currently be seen on the output, i.e. whether
+     * updating its contents requires a repaint.
+     */
+    bool is_view_visible(wayfire_view view)
+    {
+        if (!view->is_mapped() || view->minimized)
+        {
+            return false;
+        }
+
+        /* Custom renderers may show any workspace */
+        if (renderer)
+        {
+            return true;
+        }
+
+        auto toplevel = view;
+        while (toplevel->parent)
+        {
+            toplevel = toplevel->parent;
+        }
+
+        auto layer = output->workspace->get_view_layer(toplevel);
+        if (layer & (wf::BELOW_LAYERS | wf::ABOVE_LAYERS))
+        {
+            return true;
+        }
+
+        if (layer & wf::LAYER_MINIMIZED)
+        {
+            return false;
+        }
+
+        return view->sticky ||
+               (view->get_bounding_box() & output->get_relative_geometry());
+    }
+
+    /**
+     * The views on a workspace which are completely covered by opaque views
+     * above them.
+     */
+    struct occlusion_map_t
+    {
+        wf::point_t workspace;
+        std::unordered_set<wf::view_interface_t*> occluded;
+    };
+
+    /**
+     * Occlusion maps are computed on demand, at most once per frame for each
+     * workspace, and shared between the renderer and send_frame_done(), which
+     * clears them at the end of the frame.
+     */
+    std::vector<occlusion_map_t> occlusion_maps;
+
+    const occlusion_map_t& get_occlusion_map(wf::point_t ws)
+    {
+        for (auto& map : occlusion_maps)
+        {
+            if (map.workspace == ws)
+            {
+                return map;
+            }
+        }
+
+        occlusion_map_t map;
+        map.workspace = ws;
+
+        auto ws_box = output_damage->get_ws_box(ws);
+        wf::region_t covered;
+        auto views = output->workspace->get_views_on_workspace(ws,
+            wf::VISIBLE_LAYERS);
+        for (auto& v : views)
+        {
+            v->for_each_view([&] (wayfire_view view)
+            {
+                if (!view->is_visible())
+                {
+                    return true;
+                }
+
+                /* Sticky views are shown at the same position on each
+                 * workspace */
+                wf::point_t delta = {0, 0};
+                if (view->sticky)
+                {
+                    delta = {ws_box.x, ws_box.y};
+                }
+
+                auto bbox = wf::geometry_intersection(
+                    view->get_bounding_box() + delta, ws_box);
+                if ((wf::region_t{bbox} ^ covered).empty())
+                {
+                    map.occluded.insert(view.get());
+                } else
+                {
+                    covered |= view->get_transformed_opaque_region() + delta;
+                }
+
+                return true;
+            }, false);
+        }
+
+        occlusion_maps.push_back(std::move(map));
+
+        return occlusion_maps.back();
+    }
+
+    /**
+     * Check whether the view is hidden behind opaque views on the given
+     * workspace, so that it does not need to be rendered there.
+     */
+    bool is_view_occluded(wf::point_t ws, wayfire_view view)
+    {
+        /* Custom renderers may draw the views in any way */
+        if (renderer)
+        {
+            return false;
+        }
+
+        return get_occlusion_map(ws).occluded.count(view.get());
+    }
+
+    /** Drop the occlusion maps, because views may change between frames */
+    void clear_occlusion()
+    {
+        occlusion_maps.clear();
+    }
+
+    /** Interval between frame events for hidden surfaces, in milliseconds */
+    static constexpr int HIDDEN_FRAME_INTERVAL = 200;
+    wf::wl_timer hidden_frame_timer;
+    bool hidden_frame_scheduled = false;
+
+    void schedule_surface_frame(wf::surface_interface_t *surface)
+    {
+        auto view = dynamic_cast<wf::view_interface_t*>(
+            surface->get_main_surface());
+        if (!view || is_view_visible(view->self()))
+        {
+            output_damage->schedule_repaint();
+
+            return;
+        }
+
+        schedule_hidden_frame();
+    }
+
+    /** Send frame events to hidden views after HIDDEN_FRAME_INTERVAL */
+    void schedule_hidden_frame()
+    {
+        if (!hidden_frame_scheduled)
+        {
+            hidden_frame_scheduled = true;
+            hidden_frame_timer.set_timeout(HIDDEN_FRAME_INTERVAL, [=] ()
+            {
+                hidden_frame_scheduled = false;
+                send_hidden_frame_done();
+            });
+        }
+    }
+
+    /** Send frame events to the views which are not visible */
+    void send_hidden_frame_done()
+    {
+        clear_occlusion();
+
+        timespec now;
+        clockid_t presentation_clock =
+            wlr_backend_get_presentation_clock(wf::get_core_impl().backend);
+        clock_gettime(presentation_clock, &now);
+
+        auto current_ws = output->workspace->get_current_workspace();
+        auto views = output->workspace->get_views_in_layer(wf::ALL_LAYERS);
+        for (auto& v : views)
+        {
+            /* Only views in the middle layers are skipped by send_frame_done()
+             * when they are occluded */
+            bool can_occlude =
+                output->workspace->get_view_layer(v) & wf::MIDDLE_LAYERS;
+            v->for_each_view([&] (wayfire_view view)
+            {
+                if (is_view_visible(view) &&
+                    !(can_occlude && is_view_occluded(current_ws, view)))
+                {
+                    return true;
+                }
+
+                view->for_each_surface([&] (wf::surface_interface_t *surface,
+                                            wf::point_t)
+                {
+                    surface->send_frame_done(now);
+
+                    return true;
+                });
+
+                return true;
+            });
+        }
+
+        clear_occlusion();
+    }
+
     /**
      * Send frame_done to clients.
      */
     void send_frame_done()
     {
-        /* TODO: do this only if the view isn't fully occluded by another */
         std::vector<wayfire_view> visible_views;
+        size_t occludable_views = 0;
         if (renderer)
         {
             visible_views = output->workspace->get_views_in_layer(
@@ -808,6 +1537,7 @@ class wf::render_manager::impl
             visible_views = output->workspace->get_views_on_workspace(
                 output->workspace->get_current_workspace(),
                 wf::MIDDLE_LAYERS);
+            occludable_views = visible_views.size();
 
             // send to all panels/backgrounds/etc
             auto additional_views = output->workspace->get_views_in_layer(
@@ -821,33 +1551,45 @@ class wf::render_manager::impl
         clockid_t presentation_clock =
             wlr_backend_get_presentation_clock(wf::get_core_impl().backend);
         clock_gettime(presentation_clock, &repaint_ended);
-        for (auto& v : visible_views)
+
+        auto current_ws = output->workspace->get_current_workspace();
+        for (size_t i = 0; i < visible_views.size(); i++)
         {
-            for (auto& view : v->enumerate_views())
+            visible_views[i]->for_each_view([&] (wayfire_view view)
             {
-                if (!view->is_mapped())
+                /* Occluded views get throttled frame events, like views on
+                 * other workspaces */
+                if ((i < occludable_views) && is_view_occluded(current_ws, view))
                 {
-                    continue;
+                    schedule_hidden_frame();
+
+                    return true;
                 }
 
-                for (auto& child : view->enumerate_surfaces())
+                view->for_each_surface([&] (wf::surface_interface_t *surface,
+                                            wf::point_t)
                 {
-                    child.surface->send_frame_done(repaint_ended);
-                }
-            }
+                    surface->send_frame_done(repaint_ended);
+
+                    return true;
+                });
+
+                return true;
+            });
         }
+
+        clear_occlusion();
     }
 
     /* Workspace stream implementation */
     void workspace_stream_start(workspace_stream_t& stream)
     {
         stream.running = true;
-        stream.scale_x = stream.scale_y = 1;
 
         /* damage the whole workspace region, so that we get a full repaint
          * when updating the workspace */
         output_damage->damage(output_damage->get_ws_box(stream.ws));
-        workspace_stream_update(stream, 1, 1);
+        workspace_stream_update(stream, stream.scale_x, stream.scale_y);
     }
 
     /**
@@ -961,10 +1703,13 @@ class wf::render_manager::impl
         offset.x -= og.x;
         offset.y -= og.y;
 
-        for (auto& child : drag_icon->enumerate_surfaces(offset))
+        drag_icon->for_each_surface([&] (wf::surface_interface_t *surface,
+                                         wf::point_t position)
         {
-            schedule_surface(repaint, child.surface, child.position);
-        }
+            schedule_surface(repaint, surface, position);
+
+            return true;
+        }, offset);
     }
 
     /**
@@ -992,12 +1737,23 @@ class wf::render_manager::impl
         schedule_drag_icon(repaint);
         for (auto& v : views)
         {
-            for (auto& view : v->enumerate_views(false))
+            /* Everything below is covered by opaque surfaces */
+            if (repaint.ws_damage.empty())
+            {
+                break;
+            }
+
+            v->for_each_view([&] (wayfire_view view)
             {
                 wf::point_t view_delta{0, 0};
-                if (!view->is_visible() || repaint.ws_damage.empty())
+                if (!view->is_visible() || is_view_occluded(stream.ws, view))
                 {
-                    continue;
+                    return true;
+                }
+
+                if (repaint.ws_damage.empty())
+                {
+                    return false;
                 }
 
                 if (view->sticky)
@@ -1011,8 +1767,10 @@ class wf::render_manager::impl
                  * 1. The view has a transform
                  * 2. The view is visible, but not mapped
                  *    => it is snapshotted and kept alive by some plugin
+                 * 3. The view is frozen, for ex. by a view transaction
                  */
-                if (view->has_transformer() || !view->is_mapped())
+                if (view->has_transformer() || !view->is_mapped() ||
+                    wf::view_is_frozen(view))
                 {
                     /* Snapshotted views include all of their subsurfaces, so we
                      * don't recursively go into subsurfaces. */
@@ -1022,12 +1780,17 @@ class wf::render_manager::impl
                     /* Make sure view position is relative to the workspace
                      * being rendered */
                     auto obox = view->get_output_geometry() + view_delta;
-                    for (auto& child : view->enumerate_surfaces({obox.x, obox.y}))
+                    view->for_each_surface([&] (wf::surface_interface_t *surface,
+                                                wf::point_t position)
                     {
-                        schedule_surface(repaint, child.surface, child.position);
-                    }
+                        schedule_surface(repaint, surface, position);
+
+                        return true;
+                    }, {obox.x, obox.y});
                 }
-            }
+
+                return true;
+            }, false);
         }
     }
 
@@ -1040,31 +1803,44 @@ class wf::render_manager::impl
         workspace_stream_repaint_t repaint;
         repaint.ws_damage = output_damage->get_ws_damage(stream.ws);
 
-        /* we don't have to update anything */
-        if (repaint.ws_damage.empty())
+        /* Streams are scaled uniformly, so that the framebuffer scale can be
+         * used for scissoring. The default streams render directly to the
+         * output and are never scaled. */
+        float scale = std::clamp(std::max(scale_x, scale_y), 0.01f, 1.0f);
+        if (stream.buffer.tex == 0)
         {
-            return repaint;
+            scale = 1;
         }
 
-        if ((scale_x != stream.scale_x) || (scale_y != stream.scale_y))
+        if ((scale != stream.scale_x) || (scale != stream.scale_y))
         {
-            /* FIXME: enable scaled rendering */
-            // stream->scale_x = scale_x;
-            // stream->scale_y = scale_y;
+            stream.scale_x = stream.scale_y = scale;
+            repaint.ws_damage |= output_damage->get_ws_box(stream.ws);
+        }
 
-            // ws_damage |= get_damage_box();
+        /* we don't have to update anything */
+        if (repaint.ws_damage.empty())
+        {
+            return repaint;
         }
 
+        int width  = std::max(1, (int)std::round(output->handle->width * scale));
+        int height = std::max(1, (int)std::round(output->handle->height * scale));
         OpenGL::render_begin();
-        stream.buffer.allocate(output->handle->width, output->handle->height);
+        stream.buffer.allocate(width, height);
         OpenGL::render_end();
 
         repaint.fb = postprocessing->get_target_framebuffer();
         if ((stream.buffer.tex != 0))
         {
-            /* Use the workspace buffers */
+            /* Use the workspace buffers. The scene is rendered directly at the
+             * stream's resolution, by mapping the output geometry onto the
+             * smaller viewport. */
             repaint.fb.fb  = stream.buffer.fb;
             repaint.fb.tex = stream.buffer.tex;
+            repaint.fb.viewport_width  = stream.buffer.viewport_width;
+            repaint.fb.viewport_height = stream.buffer.viewport_height;
+            repaint.fb.scale *= scale;
         }
 
         auto g   = output->get_relative_geometry();
@@ -1110,10 +1886,13 @@ class wf::render_manager::impl
             {
                 repaint.fb.geometry = fb_geometry + ds->pos;
                 ds->view->render_transformed(repaint.fb, ds->damage);
-                for (auto& child : ds->view->enumerate_surfaces({0, 0}))
+                ds->view->for_each_surface([&] (wf::surface_interface_t *surface,
+                                                wf::point_t)
                 {
-                    send_sampled_on_output(child.surface);
-                }
+                    send_sampled_on_output(surface);
+
+                    return true;
+                });
             } else
             {
                 repaint.fb.geometry = fb_geometry;
@@ -1192,6 +1971,11 @@ void render_manager::schedule_redraw()
     pimpl->output_damage->schedule_repaint();
 }
 
+void render_manager::schedule_surface_frame(wf::surface_interface_t *surface)
+{
+    pimpl->schedule_surface_frame(surface);
+}
+
 void render_manager::add_inhibit(bool add)
 {
     pimpl->add_inhibit(add);
@@ -1207,6 +1991,17 @@ void render_manager::rem_effect(effect_hook_t *hook)
     pimpl->effects->rem_effect(hook);
 }
 
+void render_manager::add_animation(animation_hook_t *hook)
+{
+    pimpl->timeline->add_animation(hook);
+    pimpl->output_damage->schedule_repaint();
+}
+
+void render_manager::rem_animation(animation_hook_t *hook)
+{
+    pimpl->timeline->rem_animation(hook);
+}
+
 void render_manager::add_post(post_hook_t *hook)
 {
     pimpl->postprocessing->add_post(hook);
@@ -1247,6 +2042,16 @@ wlr_box render_manager::get_ws_box(wf::point_t ws) const
     return pimpl->output_damage->get_ws_box(ws);
 }
 
+const wf::frame_stats_t& render_manager::get_frame_stats() const
+{
+    return pimpl->frame_stats->stats;
+}
+
+const wf::frame_render_stats_t& render_manager::get_render_stats() const
+{
+    return pimpl->profiler->last;
+}
+
 wf::framebuffer_t render_manager::get_target_framebuffer() const
 {
     return pimpl->postprocessing->get_target_framebuffer();
@@ -1260,7 +2065,7 @@ void render_manager::workspace_stream_start(workspace_stream_t& stream)
 void render_manager::workspace_stream_update(workspace_stream_t& stream,
     float scale_x, float scale_y)
 {
-    pimpl->workspace_stream_update(stream);
+    pimpl->workspace_stream_update(stream, scale_x, scale_y);
 }
 
 void render_manager::workspace_stream_stop(workspace_stream_t& stream)
@@ -22,7 +22,9 @@ wf::mirror_view_t::mirror_view_t(wayfire_view base_view) :
 
     base_view_damaged = [=] (wf::signal_data_t*)
     {
-        damage();
+        /* The mirrored contents changed, so damage them as such */
+        auto size = get_size();
+        damage_surface_box({0, 0, size.width, size.height});
     };
 
     base_view->connect_signal("region-damaged", &base_view_damaged);
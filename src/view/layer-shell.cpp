@@ -71,6 +71,38 @@ wf::workspace_manager::anchored_edge anchor_to_edge(uint32_t edges)
     assert(false);
 }
 
+/** The parameters of an exclusive zone which affect the reserved areas */
+struct layer_exclusive_zone_t
+{
+    wayfire_layer_shell_view *view;
+    wf::workspace_manager::anchored_edge edge;
+    int reserved_size;
+    uint32_t desired_width, desired_height;
+    uint32_t anchor;
+    int32_t margin[4];
+
+    bool operator ==(const layer_exclusive_zone_t& other) const
+    {
+        return view == other.view && edge == other.edge &&
+               reserved_size == other.reserved_size &&
+               desired_width == other.desired_width &&
+               desired_height == other.desired_height &&
+               anchor == other.anchor &&
+               std::equal(margin, margin + 4, other.margin);
+    }
+};
+
+/** Per-output state of the layer-shell arrangement */
+struct layer_shell_output_data_t : public wf::custom_data_t
+{
+    /** Arrangement requests are coalesced into a single pass when idle */
+    wf::wl_idle_call idle_arrange;
+    /** Force reflowing reserved areas on the next arrangement */
+    bool force_reflow = true;
+    /** The exclusive zones at the time of the last reflow */
+    std::vector<layer_exclusive_zone_t> last_zones;
+};
+
 struct wf_layer_shell_manager
 {
   private:
@@ -79,7 +111,8 @@ struct wf_layer_shell_manager
         auto outputs = wf::get_core().output_layout->get_outputs();
         for (auto wo : outputs)
         {
-            arrange_layers(wo);
+            wo->get_data_safe<layer_shell_output_data_t>()->force_reflow = true;
+            schedule_arrange(wo);
         }
     };
 
@@ -106,7 +139,7 @@ struct wf_layer_shell_manager
     void handle_map(wayfire_layer_shell_view *view)
     {
         layers[view->lsurface->current.layer].push_back(view);
-        arrange_layers(view->get_output());
+        schedule_arrange(view->get_output());
     }
 
     void remove_view_from_layer(wayfire_layer_shell_view *view, uint32_t layer)
@@ -133,7 +166,7 @@ struct wf_layer_shell_manager
     {
         view->remove_anchored(false);
         remove_view_from_layer(view, view->lsurface->current.layer);
-        arrange_layers(view->get_output());
+        schedule_arrange(view->get_output());
     }
 
     layer_t filter_views(wf::output_t *output, int layer)
@@ -311,11 +344,51 @@ struct wf_layer_shell_manager
         return focus_mask;
     }
 
+    /** Collect the exclusive zones of the layer surfaces on the output */
+    std::vector<layer_exclusive_zone_t> collect_exclusive_zones(
+        wf::output_t *output)
+    {
+        std::vector<layer_exclusive_zone_t> zones;
+        for (auto v : filter_views(output))
+        {
+            if (!v->anchored_area)
+            {
+                continue;
+            }
+
+            auto& state = v->lsurface->current;
+            layer_exclusive_zone_t zone;
+            zone.view = v;
+            zone.edge = v->anchored_area->edge;
+            zone.reserved_size  = v->anchored_area->reserved_size;
+            zone.desired_width  = state.desired_width;
+            zone.desired_height = state.desired_height;
+            zone.anchor    = state.anchor;
+            zone.margin[0] = state.margin.top;
+            zone.margin[1] = state.margin.right;
+            zone.margin[2] = state.margin.bottom;
+            zone.margin[3] = state.margin.left;
+            zones.push_back(zone);
+        }
+
+        return zones;
+    }
+
+    /**
+     * Arrange the layers of the given output the next time the event loop
+     * goes idle. Multiple requests for the same output are coalesced, so that
+     * surfaces committing at the same time (for ex. at startup) cause only a
+     * single relayout.
+     */
+    void schedule_arrange(wf::output_t *output)
+    {
+        auto data = output->get_data_safe<layer_shell_output_data_t>();
+        data->idle_arrange.run_once([=] () { arrange_layers(output); });
+    }
+
     uint32_t focused_layer_request_uid = -1;
     void arrange_layers(wf::output_t *output)
     {
-        auto views = filter_views(output);
-
         arrange_layer(output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY);
         arrange_layer(output, ZWLR_LAYER_SHELL_V1_LAYER_TOP);
         arrange_layer(output, ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM);
@@ -324,14 +397,24 @@ struct wf_layer_shell_manager
         auto focus_mask = determine_focused_layer();
         focused_layer_request_uid = wf::get_core().focus_layer(focus_mask,
             focused_layer_request_uid);
-        output->workspace->reflow_reserved_areas();
+
+        /* Reflowing reconfigures maximized and tiled views, so do it only if
+         * the exclusive zones have actually changed */
+        auto data  = output->get_data_safe<layer_shell_output_data_t>();
+        auto zones = collect_exclusive_zones(output);
+        if (data->force_reflow || (zones != data->last_zones))
+        {
+            data->force_reflow = false;
+            data->last_zones   = std::move(zones);
+            output->workspace->reflow_reserved_areas();
+        }
     }
 };
 
 wayfire_layer_shell_view::wayfire_layer_shell_view(wlr_layer_surface_v1 *lsurf) :
     wf::wlr_view_t(), lsurface(lsurf)
 {
-    LOGD("Create a layer surface: namespace ", lsurf->namespace_t,
+    LOGC(VIEWS, "Create a layer surface: namespace ", lsurf->namespace_t,
         " layer ", lsurf->current.layer);
 
     role = wf::VIEW_ROLE_DESKTOP_ENVIRONMENT;
@@ -455,12 +538,12 @@ void wayfire_layer_shell_view::commit()
         if (prev_state.layer != state->layer)
         {
             get_output()->workspace->add_view(self(), get_layer());
-            /* Will also trigger reflowing */
+            /* Will also schedule reflowing */
             wf_layer_shell_manager::get_instance().handle_move_layer(this);
         } else
         {
             /* Reflow reserved areas and positions */
-            wf_layer_shell_manager::get_instance().arrange_layers(get_output());
+            wf_layer_shell_manager::get_instance().schedule_arrange(get_output());
         }
 
         prev_state = *state;
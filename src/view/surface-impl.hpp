@@ -24,6 +24,17 @@ class surface_interface_t::impl
      * subtract_opaque(), send_frame_done(), etc. work for the surface
      */
     wlr_surface *wsurface = nullptr;
+
+    /** Incremented whenever the opaque region of the surface changes */
+    uint64_t opaque_serial = 0;
+    /**
+     * The opaque region of wsurface relative to the surface, shrunk by
+     * opaque_cache_shrink. Valid only if opaque_cache_serial matches
+     * opaque_serial.
+     */
+    wf::region_t opaque_cache;
+    int opaque_cache_shrink = 0;
+    uint64_t opaque_cache_serial = -1;
 };
 
 /**
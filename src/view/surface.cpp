@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <map>
 #include <wayfire/util/log.hpp>
+#include <wayfire/nonstd/reverse.hpp>
 #include "surface-impl.hpp"
 #include "subsurface.hpp"
 #include "wayfire/opengl.hpp"
@@ -60,35 +61,92 @@ std::vector<wf::surface_iterator_t> wf::surface_interface_t::enumerate_surfaces(
     wf::point_t surface_origin)
 {
     std::vector<wf::surface_iterator_t> result;
-    auto add_surfaces_recursive = [&] (surface_interface_t *child)
+    for_each_surface([&] (wf::surface_interface_t *surface, wf::point_t origin)
+    {
+        result.push_back({surface, origin});
+
+        return true;
+    }, surface_origin);
+
+    return result;
+}
+
+bool wf::surface_interface_t::for_each_surface(
+    wf::function_ref<bool(surface_interface_t*, wf::point_t)> callback,
+    wf::point_t surface_origin)
+{
+    auto visit_child = [&] (surface_interface_t *child)
     {
         if (!child->is_mapped())
         {
-            return;
+            return true;
         }
 
-        auto child_surfaces = child->enumerate_surfaces(
+        return child->for_each_surface(callback,
             child->get_offset() + surface_origin);
-        result.insert(result.end(),
-            child_surfaces.begin(), child_surfaces.end());
     };
 
     for (auto& child : priv->surface_children_above)
     {
-        add_surfaces_recursive(child.get());
+        if (!visit_child(child.get()))
+        {
+            return false;
+        }
     }
 
-    if (is_mapped())
+    if (is_mapped() && !callback(this, surface_origin))
     {
-        result.push_back({this, surface_origin});
+        return false;
     }
 
     for (auto& child : priv->surface_children_below)
     {
-        add_surfaces_recursive(child.get());
+        if (!visit_child(child.get()))
+        {
+            return false;
+        }
     }
 
-    return result;
+    return true;
+}
+
+bool wf::surface_interface_t::for_each_surface_reverse(
+    wf::function_ref<bool(surface_interface_t*, wf::point_t)> callback,
+    wf::point_t surface_origin)
+{
+    auto visit_child = [&] (surface_interface_t *child)
+    {
+        if (!child->is_mapped())
+        {
+            return true;
+        }
+
+        return child->for_each_surface_reverse(callback,
+            child->get_offset() + surface_origin);
+    };
+
+    for (auto& child : wf::reverse(priv->surface_children_below))
+    {
+        if (!visit_child(child.get()))
+        {
+            return false;
+        }
+    }
+
+    if (is_mapped() && !callback(this, surface_origin))
+    {
+        return false;
+    }
+
+    for (auto& child : wf::reverse(priv->surface_children_above))
+    {
+        if (!visit_child(child.get()))
+        {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 wf::output_t*wf::surface_interface_t::get_output()
@@ -162,11 +220,22 @@ wf::region_t wf::surface_interface_t::get_opaque_region(wf::point_t origin)
         return {};
     }
 
-    wf::region_t opaque{&priv->wsurface->opaque_region};
-    opaque += origin;
-    opaque.expand_edges(-get_active_shrink_constraint());
+    int shrink = get_active_shrink_constraint();
+    if ((priv->opaque_cache_serial != priv->opaque_serial) ||
+        (priv->opaque_cache_shrink != shrink))
+    {
+        priv->opaque_cache = wf::region_t{&priv->wsurface->opaque_region};
+        priv->opaque_cache.expand_edges(-shrink);
+        priv->opaque_cache_shrink = shrink;
+        priv->opaque_cache_serial = priv->opaque_serial;
+    }
+
+    return priv->opaque_cache + origin;
+}
 
-    return opaque;
+void wf::surface_interface_t::invalidate_opaque_region()
+{
+    ++priv->opaque_serial;
 }
 
 wl_client*wf::surface_interface_t::get_client()
@@ -281,6 +350,7 @@ void wf::wlr_surface_base_t::map(wlr_surface *surface)
     this->surface = surface;
 
     _as_si->priv->wsurface = surface;
+    _as_si->invalidate_opaque_region();
 
     /* force surface_send_enter(), and also check whether parent surface
      * output hasn't changed while we were unmapped */
@@ -311,6 +381,7 @@ void wf::wlr_surface_base_t::unmap()
     this->surface->data = NULL;
     this->surface = nullptr;
     this->_as_si->priv->wsurface = nullptr;
+    _as_si->invalidate_opaque_region();
     emit_map_state_change(_as_si);
 
     on_new_subsurface.disconnect();
@@ -349,12 +420,13 @@ void wf::wlr_surface_base_t::apply_surface_damage()
 
 void wf::wlr_surface_base_t::commit()
 {
+    _as_si->invalidate_opaque_region();
     apply_surface_damage();
     if (_as_si->get_output())
     {
-        /* we schedule redraw, because the surface might expect
-         * a frame callback */
-        _as_si->get_output()->render->schedule_redraw();
+        /* The surface might expect a frame callback. If it is hidden, this
+         * does not cause a repaint of the output. */
+        _as_si->get_output()->render->schedule_surface_frame(_as_si);
     }
 }
 
@@ -385,8 +457,20 @@ void wf::wlr_surface_base_t::_simple_render(const wf::framebuffer_t& fb,
     wf::geometry_t geometry = {x, y, size.width, size.height};
     wf::texture_t texture{surface->buffer->texture};
 
+    /* Parts covered by the opaque region are drawn without blending. Surfaces
+     * below them are not drawn at all, see the render manager. */
+    wf::region_t opaque      = damage & _as_si->get_opaque_region({x, y});
+    wf::region_t translucent = damage ^ opaque;
+
     OpenGL::render_begin(fb);
-    for (const auto& rect : damage)
+    for (const auto& rect : opaque)
+    {
+        fb.logic_scissor(wlr_box_from_pixman_box(rect));
+        OpenGL::render_texture(texture, fb, geometry, glm::vec4(1.f),
+            OpenGL::TEXTURE_OPAQUE);
+    }
+
+    for (const auto& rect : translucent)
     {
         fb.logic_scissor(wlr_box_from_pixman_box(rect));
         OpenGL::render_texture(texture, fb, geometry);
@@ -145,6 +145,49 @@ wf::pointf_t wf::view_2D::untransform_point(
     return get_absolute_coords_from_relative(view->get_wm_geometry(), {x, y});
 }
 
+uint64_t wf::view_2D::get_transform_serial()
+{
+    const float params[5] = {angle, scale_x, scale_y, translation_x,
+        translation_y};
+    if (!std::equal(params, params + 5, last_params))
+    {
+        std::copy(params, params + 5, last_params);
+        ++serial;
+    }
+
+    return serial;
+}
+
+bool wf::view_2D::get_affine_transform(wf::geometry_t geometry,
+    glm::mat3& matrix)
+{
+    /* Same as transform_point(): scale and rotate around the center of the
+     * view, then translate. Note that the y axis points downwards here. */
+    auto wm = view->get_wm_geometry();
+    float cx = wm.x + wm.width / 2.0;
+    float cy = wm.y + wm.height / 2.0;
+    float c  = std::cos(angle);
+    float s  = std::sin(angle);
+
+    matrix = glm::mat3(1.0);
+    matrix[0][0] = c * scale_x;
+    matrix[1][0] = s * scale_y;
+    matrix[0][1] = -s * scale_x;
+    matrix[1][1] = c * scale_y;
+    matrix[2][0] = cx + translation_x - (matrix[0][0] * cx + matrix[1][0] * cy);
+    matrix[2][1] = cy + translation_y - (matrix[0][1] * cx + matrix[1][1] * cy);
+
+    return true;
+}
+
+wf::dimensions_t wf::view_2D::get_displayed_size(wf::geometry_t geometry)
+{
+    return {
+        (int)std::ceil(geometry.width * std::abs(scale_x)),
+        (int)std::ceil(geometry.height * std::abs(scale_y)),
+    };
+}
+
 void wf::view_2D::render_box(wf::texture_t src_tex, wlr_box src_box,
     wlr_box scissor_box, const wf::framebuffer_t& fb)
 {
@@ -193,14 +236,43 @@ wf::view_3D::view_3D(wayfire_view view)
     view_proj  = default_proj_matrix() * default_view_matrix();
 }
 
-/* TODO: cache total_transform, because it is often unnecessarily recomputed */
-glm::mat4 wf::view_3D::calculate_total_transform()
+void wf::view_3D::update_total_transform()
 {
     auto og = view->get_output()->get_relative_geometry();
+    wf::dimensions_t output_size = {og.width, og.height};
+
+    if (total_transform_valid && (cached_output_size == output_size) &&
+        (cached_view_proj == view_proj) && (cached_translation == translation) &&
+        (cached_rotation == rotation) && (cached_scaling == scaling))
+    {
+        return;
+    }
+
     glm::mat4 depth_scale =
         glm::scale(glm::mat4(1.0), {1, 1, 2.0 / std::min(og.width, og.height)});
+    total_transform = translation * view_proj * depth_scale * rotation * scaling;
+
+    cached_output_size = output_size;
+    cached_view_proj   = view_proj;
+    cached_translation = translation;
+    cached_rotation    = rotation;
+    cached_scaling     = scaling;
+    total_transform_valid = true;
+    ++serial;
+}
+
+glm::mat4 wf::view_3D::calculate_total_transform()
+{
+    update_total_transform();
 
-    return translation * view_proj * depth_scale * rotation * scaling;
+    return total_transform;
+}
+
+uint64_t wf::view_3D::get_transform_serial()
+{
+    update_total_transform();
+
+    return serial;
 }
 
 wf::pointf_t wf::view_3D::transform_point(
@@ -234,6 +306,12 @@ wf::pointf_t wf::view_3D::untransform_point(wf::geometry_t geometry,
         wf::compositor_core_t::invalid_coordinate};
 }
 
+wf::dimensions_t wf::view_3D::get_displayed_size(wf::geometry_t geometry)
+{
+    auto box = get_bounding_box(geometry, geometry);
+    return {box.width, box.height};
+}
+
 void wf::view_3D::render_box(wf::texture_t src_tex, wlr_box src_box,
     wlr_box scissor_box, const wf::framebuffer_t& fb)
 {
@@ -119,8 +119,8 @@ void wf::wlr_view_t::set_position(int x, int y,
     geometry.y = y + obox.y - wm.y;
 
     /* Make sure that if we move the view while it is unmapped, its snapshot
-     * is still valid coordinates */
-    if (view_impl->offscreen_buffer.valid())
+     * is still valid coordinates. Frozen views stay where they were. */
+    if (view_impl->offscreen_buffer.valid() && !view_impl->frozen_counter)
     {
         view_impl->offscreen_buffer.geometry.x += x - data.old_geometry.x;
         view_impl->offscreen_buffer.geometry.y += y - data.old_geometry.y;
@@ -227,6 +227,67 @@ bool wf::wlr_view_t::should_resize_client(
     }
 }
 
+bool wf::wlr_view_t::defer_resize(wf::dimensions_t size)
+{
+    if (!view_impl->in_continuous_resize || !configure_outstanding)
+    {
+        /* A request which is sent right away supersedes the deferred one */
+        deferred_size.reset();
+
+        return false;
+    }
+
+    deferred_size = size;
+
+    return true;
+}
+
+void wf::wlr_view_t::notify_size_configured()
+{
+    if (view_impl->in_continuous_resize)
+    {
+        configure_outstanding = true;
+    }
+}
+
+bool wf::wlr_view_t::is_configure_acked()
+{
+    return true;
+}
+
+void wf::wlr_view_t::flush_deferred_resize()
+{
+    if (!configure_outstanding || !is_configure_acked())
+    {
+        return;
+    }
+
+    configure_outstanding = false;
+    if (deferred_size)
+    {
+        auto size = *deferred_size;
+        deferred_size.reset();
+        resize(size.width, size.height);
+    }
+}
+
+void wf::wlr_view_t::set_resizing(bool resizing, uint32_t edges)
+{
+    view_interface_t::set_resizing(resizing, edges);
+
+    /* Make sure the final size of the resize is not lost */
+    if (!view_impl->in_continuous_resize)
+    {
+        configure_outstanding = false;
+        if (deferred_size)
+        {
+            auto size = *deferred_size;
+            deferred_size.reset();
+            resize(size.width, size.height);
+        }
+    }
+}
+
 wf::geometry_t wf::wlr_view_t::get_output_geometry()
 {
     return geometry;
@@ -4,9 +4,11 @@
 #include <wayfire/nonstd/safe-list.hpp>
 #include <wayfire/view.hpp>
 #include <wayfire/opengl.hpp>
+#include <glm/mat3x3.hpp>
 
 #include "surface-impl.hpp"
 #include <wayfire/nonstd/wlroots-full.hpp>
+#include <optional>
 
 // for emit_map_*()
 #include <wayfire/compositor-view.hpp>
@@ -62,6 +64,72 @@ class view_interface_t::view_priv_impl
     int visibility_counter   = 1;
 
     wf::safe_list_t<std::shared_ptr<view_transform_block_t>> transforms;
+    /** Incremented whenever a transformer is added or removed */
+    uint64_t transformer_generation = 0;
+
+    /**
+     * Geometry computed from the transformers, reused while the view's
+     * geometry and its transformers' serials stay the same.
+     * See view_transformer_t::get_transform_serial().
+     */
+    struct transform_cache_t
+    {
+        /** Whether the cache may be reused at all */
+        bool valid = false;
+        /** Incremented each time the cache is recomputed */
+        uint64_t version = 0;
+
+        /* The state the cache was computed for */
+        uint64_t generation = 0;
+        wf::geometry_t untransformed_box = {0, 0, 0, 0};
+        wf::geometry_t wm_geometry = {0, 0, 0, 0};
+        std::vector<uint64_t> serials;
+
+        /** The bounding box of the view before each transformer */
+        std::vector<wf::geometry_t> boxes;
+        /** The bounding box of the view after all transformers */
+        wf::geometry_t bounding_box = {0, 0, 0, 0};
+
+        /** Whether all transformers are affine, see forward and inverse */
+        bool affine = false;
+        /** Whether the composed affine transformation can be reversed */
+        bool invertible = false;
+        glm::mat3 forward{1.0}, inverse{1.0};
+    } transform_cache;
+
+    /**
+     * The transformed opaque region of the view, reused until one of its
+     * surfaces changes its opaque region or position, or the transformers
+     * change. There is one entry per shrink constraint, because for ex. blur
+     * alternates between two constraints in the same frame.
+     */
+    struct opaque_cache_t
+    {
+        struct surface_state_t
+        {
+            surface_interface_t *surface;
+            uint64_t opaque_serial;
+            wf::point_t position;
+        };
+
+        /** transform_version of a view without transformers */
+        static constexpr uint64_t NO_TRANSFORMERS = 0;
+
+        std::vector<surface_state_t> surfaces;
+        /**
+         * The version of the transform cache, or NO_TRANSFORMERS. Transform
+         * cache versions start at 1.
+         */
+        uint64_t transform_version = NO_TRANSFORMERS;
+        std::vector<std::pair<int, wf::region_t>> regions;
+
+        /** Force the region to be recomputed on the next query */
+        void invalidate()
+        {
+            surfaces.clear();
+            regions.clear();
+        }
+    } opaque_cache;
 
     struct offscreen_buffer_t : public wf::framebuffer_t
     {
@@ -72,6 +140,16 @@ class view_interface_t::view_priv_impl
         }
     } offscreen_buffer;
 
+    /**
+     * While positive, the view is drawn from the snapshot taken when it was
+     * frozen, see view_set_frozen().
+     */
+    int frozen_counter = 0;
+
+    /** Incremented whenever the contents of the view are damaged, as opposed
+     * to damage caused by transformer changes. Used by view thumbnails. */
+    uint64_t content_damage_serial = 0;
+
     wlr_box minimize_hint = {0, 0, 0, 0};
 
   private:
@@ -98,6 +176,20 @@ class view_interface_t::view_priv_impl
  */
 void view_damage_raw(wayfire_view view, const wlr_box& box);
 
+/**
+ * Freeze or thaw the view. A frozen view is drawn from a snapshot of the
+ * contents it had when it was frozen, at the position it had then, like an
+ * unmapped view kept alive by a plugin. New buffers and geometry changes are
+ * shown once it is thawed again.
+ *
+ * Calls can be nested, the view is thawed when it has been unfrozen as many
+ * times as it was frozen.
+ */
+void view_set_frozen(wayfire_view view, bool frozen);
+
+/** @return Whether the view is frozen, see view_set_frozen() */
+bool view_is_frozen(wayfire_view view);
+
 /**
  * Implementation of a view backed by a wlr_* shell struct.
  */
@@ -119,6 +211,7 @@ class wlr_view_t :
 
     /* Functions which are further specialized for the different shells */
     virtual void move(int x, int y) override;
+    virtual void set_resizing(bool resizing, uint32_t edges = 0) override;
     virtual wf::geometry_t get_wm_geometry() override;
     virtual wf::geometry_t get_output_geometry() override;
 
@@ -170,6 +263,33 @@ class wlr_view_t :
     virtual bool should_resize_client(wf::dimensions_t request,
         wf::dimensions_t current_size);
 
+    /*
+     * Resize pacing: during interactive resize, at most one configure with a
+     * new size is outstanding. Sizes requested in the meantime are coalesced,
+     * and the last one is sent once the client has committed in response to
+     * the outstanding configure. This way slow clients do not fall behind the
+     * pointer by a long queue of configures.
+     */
+    bool configure_outstanding = false;
+    std::optional<wf::dimensions_t> deferred_size;
+
+    /**
+     * Check whether a resize request has to wait for the outstanding
+     * configure. In that case, the size is stored and sent later.
+     *
+     * @return true if the request was deferred.
+     */
+    bool defer_resize(wf::dimensions_t size);
+    /** Must be called by view implementations after sending a new size */
+    void notify_size_configured();
+    /** Send the deferred size, if the outstanding configure has been acked */
+    void flush_deferred_resize();
+    /**
+     * @return Whether the client has acknowledged the last configure. The
+     * default implementation assumes that every commit does.
+     */
+    virtual bool is_configure_acked();
+
     virtual void commit() override;
     virtual void map(wlr_surface *surface) override;
     virtual void unmap() override;
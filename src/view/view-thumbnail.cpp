@@ -0,0 +1,159 @@
+#include "wayfire/view-thumbnail.hpp"
+#include "wayfire/output.hpp"
+#include "view-impl.hpp"
+
+#include <algorithm>
+
+class wf::view_thumbnail_t::impl
+{
+  public:
+    wayfire_view view;
+
+    /** The downscaled copy of the view */
+    wf::framebuffer_base_t thumbnail;
+    /** Intermediate steps of the downscaling, kept for the next update */
+    wf::framebuffer_base_t scratch[2];
+    /** Whether the thumbnail has contents at all */
+    bool valid = false;
+    /** The content serial of the view when the snapshot was last taken */
+    uint64_t snapshot_serial = 0;
+    /** The content serial of the view when the thumbnail was last rendered */
+    uint64_t thumbnail_serial = 0;
+    /** The size of the snapshot the thumbnail was rendered from */
+    wf::dimensions_t source_size = {0, 0};
+    /** The size of the texture returned last */
+    wf::dimensions_t size = {0, 0};
+
+    /**
+     * Render source_tex (of the given size) downscaled to the target size.
+     * Each step halves the size at most, so that every source pixel
+     * contributes to the result when sampling linearly.
+     */
+    void render_downscaled(GLuint source_tex, wf::dimensions_t current,
+        wf::dimensions_t target)
+    {
+        int next_scratch = 0;
+
+        while (current.width != target.width || current.height != target.height)
+        {
+            current.width  = std::max(current.width / 2, target.width);
+            current.height = std::max(current.height / 2, target.height);
+
+            bool last = (current.width == target.width) &&
+                (current.height == target.height);
+            auto& buffer = last ? thumbnail : scratch[next_scratch];
+
+            OpenGL::render_begin();
+            buffer.allocate(current.width, current.height);
+            buffer.bind();
+            OpenGL::clear({0, 0, 0, 0});
+            OpenGL::render_transformed_texture(wf::texture_t{source_tex},
+                gl_geometry{-1, 1, 1, -1}, {}, glm::mat4(1.0));
+            OpenGL::render_end();
+
+            source_tex   = buffer.tex;
+            next_scratch = 1 - next_scratch;
+        }
+    }
+};
+
+/**
+ * The smallest size which can be reached from source by halving it, and which
+ * is not smaller than target.
+ */
+static int quantize_size(int source, int target)
+{
+    while (source / 2 >= target)
+    {
+        source /= 2;
+    }
+
+    return source;
+}
+
+nonstd::observer_ptr<wf::view_thumbnail_t> wf::view_thumbnail_t::get(
+    wayfire_view view)
+{
+    if (!view->has_data<view_thumbnail_t>())
+    {
+        view->store_data(std::make_unique<view_thumbnail_t>(view));
+    }
+
+    return view->get_data<view_thumbnail_t>();
+}
+
+wf::view_thumbnail_t::view_thumbnail_t(wayfire_view view)
+{
+    this->priv = std::make_unique<impl>();
+    priv->view = view;
+}
+
+wf::view_thumbnail_t::~view_thumbnail_t()
+{
+    OpenGL::render_begin();
+    priv->thumbnail.release();
+    priv->scratch[0].release();
+    priv->scratch[1].release();
+    OpenGL::render_end();
+}
+
+wf::dimensions_t wf::view_thumbnail_t::get_size() const
+{
+    return priv->size;
+}
+
+wf::texture_t wf::view_thumbnail_t::get_texture(wf::dimensions_t size)
+{
+    auto view = priv->view;
+    auto& snapshot = view->view_impl->offscreen_buffer;
+    uint64_t serial = view->view_impl->content_damage_serial;
+
+    /* Transformer changes also add to the snapshot's damage, so we take a new
+     * snapshot only if the contents have actually changed. Unmapped and
+     * frozen views keep their last snapshot. */
+    bool snapshot_outdated = !snapshot.valid() ||
+        (priv->snapshot_serial != serial);
+    if (snapshot_outdated && view->is_mapped() && view->get_output() &&
+        !wf::view_is_frozen(view))
+    {
+        view->take_snapshot();
+        priv->snapshot_serial = serial;
+    }
+
+    if (!snapshot.valid())
+    {
+        priv->size = {0, 0};
+
+        return wf::texture_t{(GLuint)-1};
+    }
+
+    wf::dimensions_t source_size = {
+        snapshot.viewport_width, snapshot.viewport_height};
+    /* Sizes change each frame during animations, so the thumbnail is rebuilt
+     * only when the requested size crosses a halving step */
+    size.width  = quantize_size(source_size.width, std::max(size.width, 1));
+    size.height = quantize_size(source_size.height, std::max(size.height, 1));
+    priv->size  = size;
+
+    /* Nothing to downscale */
+    if (size == source_size)
+    {
+        return wf::texture_t{snapshot.tex};
+    }
+
+    bool needs_update = !priv->valid ||
+        (priv->thumbnail_serial != priv->snapshot_serial) ||
+        (priv->source_size != source_size) ||
+        (priv->thumbnail.viewport_width != size.width) ||
+        (priv->thumbnail.viewport_height != size.height);
+
+    if (needs_update)
+    {
+        priv->render_downscaled(snapshot.tex, source_size, size);
+        priv->valid = true;
+        priv->thumbnail_serial = priv->snapshot_serial;
+        priv->source_size = source_size;
+    }
+
+    return wf::texture_t{priv->thumbnail.tex};
+}
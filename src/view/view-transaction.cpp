@@ -0,0 +1,251 @@
+#include "wayfire/view-transaction.hpp"
+#include "wayfire/core.hpp"
+#include "wayfire/signal-definitions.hpp"
+#include "view-impl.hpp"
+#include <wayfire/util.hpp>
+#include <wayfire/util/log.hpp>
+#include <wayfire/debug.hpp>
+
+#include <algorithm>
+
+namespace
+{
+using view_geometry_list_t = std::vector<std::pair<wayfire_view, wf::geometry_t>>;
+
+/**
+ * Tracks a committed transaction until all of its views have committed their
+ * new size. The views stay frozen until then, so that they are all shown with
+ * their new size at once. The barrier manages its own lifetime.
+ */
+class transaction_barrier_t
+{
+    /** All barriers which are still waiting */
+    static std::vector<transaction_barrier_t*> active;
+
+    struct waiting_view_t
+    {
+        wayfire_view view;
+        wf::dimensions_t target;
+        wf::dimensions_t initial;
+    };
+
+    /** Views which have not yet committed a new size */
+    std::vector<waiting_view_t> waiting;
+    /** All views of the transaction, thawed when it is done */
+    std::vector<wayfire_view> frozen;
+
+    wf::wl_timer timeout;
+    bool done = false;
+
+    wf::signal_connection_t on_view_changed = [=] (wf::signal_data_t *data)
+    {
+        check_view(wf::get_signaled_view(data));
+    };
+
+    /**
+     * Stop waiting for the view if it has committed a new size. Clients may
+     * not be able to use exactly the requested size (for ex. terminals with
+     * size increments), so any size change counts.
+     */
+    void check_view(wayfire_view view)
+    {
+        auto it = std::find_if(waiting.begin(), waiting.end(),
+            [&] (const auto& entry) { return entry.view == view; });
+        if (it == waiting.end())
+        {
+            return;
+        }
+
+        auto wm = view->get_wm_geometry();
+        wf::dimensions_t size = {wm.width, wm.height};
+        if (!view->is_mapped() || (size == it->target) || (size != it->initial))
+        {
+            release_view(view);
+        }
+    }
+
+    /** Stop waiting for the given view */
+    void release_view(wayfire_view view)
+    {
+        auto it = std::find_if(waiting.begin(), waiting.end(),
+            [&] (const auto& entry) { return entry.view == view; });
+        if (it == waiting.end())
+        {
+            return;
+        }
+
+        view->disconnect_signal(&on_view_changed);
+        view->unref();
+        waiting.erase(it);
+
+        if (waiting.empty())
+        {
+            finish();
+        }
+    }
+
+    /** Release and thaw all views and destroy the barrier */
+    void finish()
+    {
+        if (done)
+        {
+            return;
+        }
+
+        done = true;
+        active.erase(std::find(active.begin(), active.end(), this));
+        timeout.disconnect();
+        on_view_changed.disconnect();
+        for (auto& entry : waiting)
+        {
+            entry.view->unref();
+        }
+
+        waiting.clear();
+
+        for (auto& view : frozen)
+        {
+            wf::view_set_frozen(view, false);
+            view->unref();
+        }
+
+        frozen.clear();
+
+        /* We may be inside one of our own signal handlers, so delay the
+         * destruction until it is safe */
+        wl_event_loop_add_idle(wf::get_core().ev_loop, [] (void *data)
+        {
+            delete (transaction_barrier_t*)data;
+        }, this);
+    }
+
+  public:
+    transaction_barrier_t(const view_geometry_list_t& views, uint32_t timeout_ms)
+    {
+        active.push_back(this);
+        for (auto& [view, geometry] : views)
+        {
+            if (!view->is_mapped())
+            {
+                continue;
+            }
+
+            /* Freeze before older transactions thaw the view, so that the
+             * snapshot shows the last complete layout */
+            view->take_ref();
+            wf::view_set_frozen(view, true);
+            frozen.push_back(view);
+
+            /* Older transactions should not wait for a size which has been
+             * superseded by this transaction */
+            auto older = active;
+            for (auto barrier : older)
+            {
+                if (barrier != this)
+                {
+                    barrier->release_view(view);
+                }
+            }
+
+            auto wm = view->get_wm_geometry();
+            view->take_ref();
+            view->connect_signal("geometry-changed", &on_view_changed);
+            view->connect_signal("unmapped", &on_view_changed);
+            waiting.push_back({view, {geometry.width, geometry.height},
+                {wm.width, wm.height}});
+        }
+
+        /* Send all configures at once */
+        auto targets = waiting;
+        for (auto& entry : targets)
+        {
+            auto it = std::find_if(views.begin(), views.end(),
+                [&] (const auto& v) { return v.first == entry.view; });
+            entry.view->set_geometry(it->second);
+        }
+
+        /* Some views might not need to change their size at all */
+        for (auto& entry : targets)
+        {
+            check_view(entry.view);
+        }
+
+        if (waiting.empty())
+        {
+            finish();
+        } else if (!done)
+        {
+            timeout.set_timeout(timeout_ms, [=] ()
+            {
+                LOGC(VIEWS, "Transaction timed out, ", waiting.size(),
+                    " view(s) did not commit in time");
+                finish();
+            });
+        }
+    }
+};
+
+std::vector<transaction_barrier_t*> transaction_barrier_t::active;
+}
+
+class wf::view_transaction_t::impl
+{
+  public:
+    uint32_t timeout;
+    bool committed = false;
+    view_geometry_list_t views;
+};
+
+wf::view_transaction_t::view_transaction_t(uint32_t timeout)
+{
+    this->priv = std::make_unique<impl>();
+    priv->timeout = timeout;
+}
+
+wf::view_transaction_t::~view_transaction_t()
+{
+    commit();
+}
+
+void wf::view_transaction_t::set_geometry(wayfire_view view,
+    wf::geometry_t geometry)
+{
+    auto it = std::find_if(priv->views.begin(), priv->views.end(),
+        [&] (const auto& entry) { return entry.first == view; });
+    if (it != priv->views.end())
+    {
+        it->second = geometry;
+    } else
+    {
+        /* Keep the view alive until the transaction is committed */
+        view->take_ref();
+        priv->views.push_back({view, geometry});
+    }
+}
+
+bool wf::view_transaction_t::empty() const
+{
+    return priv->views.empty();
+}
+
+void wf::view_transaction_t::commit()
+{
+    if (priv->committed)
+    {
+        return;
+    }
+
+    priv->committed = true;
+    if (priv->views.empty())
+    {
+        return;
+    }
+
+    new transaction_barrier_t(priv->views, priv->timeout);
+    for (auto& entry : priv->views)
+    {
+        entry.first->unref();
+    }
+
+    priv->views.clear();
+}
@@ -5,6 +5,7 @@
 #include "wayfire/output.hpp"
 #include "wayfire/view.hpp"
 #include "wayfire/view-transform.hpp"
+#include "wayfire/view-thumbnail.hpp"
 #include "wayfire/decorator.hpp"
 #include "wayfire/workspace-manager.hpp"
 #include "wayfire/render-manager.hpp"
@@ -12,6 +13,7 @@
 #include "../output/gtk-shell.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <glm/glm.hpp>
 #include "wayfire/signal-definitions.hpp"
 
@@ -148,22 +150,35 @@ void wf::view_interface_t::set_toplevel_parent(wayfire_view new_parent)
 
 std::vector<wayfire_view> wf::view_interface_t::enumerate_views(
     bool mapped_only)
+{
+    std::vector<wayfire_view> result;
+    for_each_view([&] (wayfire_view view)
+    {
+        result.push_back(view);
+
+        return true;
+    }, mapped_only);
+
+    return result;
+}
+
+bool wf::view_interface_t::for_each_view(
+    wf::function_ref<bool(wayfire_view)> callback, bool mapped_only)
 {
     if (!this->is_mapped() && mapped_only)
     {
-        return {};
+        return true;
     }
 
-    std::vector<wayfire_view> result;
     for (auto& v : this->children)
     {
-        auto cdr = v->enumerate_views(mapped_only);
-        result.insert(result.end(), cdr.begin(), cdr.end());
+        if (!v->for_each_view(callback, mapped_only))
+        {
+            return false;
+        }
     }
 
-    result.push_back(self());
-
-    return result;
+    return callback(self());
 }
 
 void wf::view_interface_t::set_role(view_role_t new_role)
@@ -277,9 +292,129 @@ wf::geometry_t wf::view_interface_t::get_wm_geometry()
     return get_output_geometry();
 }
 
+using transform_cache_t = wf::view_interface_t::view_priv_impl::transform_cache_t;
+
+/**
+ * Get the transform cache of the view, recomputing it if the view's geometry
+ * or any of its transformers have changed since it was last computed.
+ */
+static const transform_cache_t& get_transform_cache(wf::view_interface_t *view)
+{
+    auto& priv  = view->view_impl;
+    auto& cache = priv->transform_cache;
+    auto box    = view->get_untransformed_bounding_box();
+    auto wm     = view->get_wm_geometry();
+
+    bool up_to_date = cache.valid && (cache.generation ==
+        priv->transformer_generation) && (cache.untransformed_box == box) &&
+        (cache.wm_geometry == wm);
+
+    size_t idx = 0;
+    priv->transforms.for_each([&] (auto& tr)
+    {
+        up_to_date &= (idx < cache.serials.size()) &&
+            (cache.serials[idx] == tr->transform->get_transform_serial());
+        ++idx;
+    });
+
+    if (up_to_date && (idx == cache.serials.size()))
+    {
+        return cache;
+    }
+
+    bool cacheable = true;
+    cache.serials.clear();
+    cache.boxes.clear();
+    cache.affine  = true;
+    cache.forward = glm::mat3(1.0);
+
+    auto bbox = box;
+    priv->transforms.for_each([&] (auto& tr)
+    {
+        auto& transform = tr->transform;
+        uint64_t serial = transform->get_transform_serial();
+        cacheable &= (serial != 0);
+        cache.serials.push_back(serial);
+        cache.boxes.push_back(bbox);
+
+        glm::mat3 matrix;
+        if (cache.affine && transform->get_affine_transform(bbox, matrix))
+        {
+            cache.forward = matrix * cache.forward;
+        } else
+        {
+            cache.affine = false;
+        }
+
+        bbox = transform->get_bounding_box(bbox, bbox);
+    });
+
+    cache.bounding_box = bbox;
+    cache.invertible   = cache.affine &&
+        (std::abs(glm::determinant(cache.forward)) > 1e-6);
+    if (cache.invertible)
+    {
+        cache.inverse = glm::inverse(cache.forward);
+    }
+
+    cache.valid = cacheable;
+    ++cache.version;
+    cache.generation  = priv->transformer_generation;
+    cache.untransformed_box = box;
+    cache.wm_geometry = wm;
+
+    return cache;
+}
+
+/** Transform a point with a 2D affine matrix */
+static wf::pointf_t transform_point_affine(const glm::mat3& matrix,
+    wf::pointf_t point)
+{
+    auto v = matrix * glm::vec3(point.x, point.y, 1.0);
+
+    return {v.x, v.y};
+}
+
+/**
+ * Get the bounding box of the box transformed by the 2D affine matrix,
+ * rounded outwards to whole pixels.
+ */
+static wlr_box transform_box_affine(const glm::mat3& matrix, wlr_box box)
+{
+    const wf::pointf_t corners[4] = {
+        {1.0 * box.x, 1.0 * box.y},
+        {1.0 * box.x + box.width, 1.0 * box.y},
+        {1.0 * box.x, 1.0 * box.y + box.height},
+        {1.0 * box.x + box.width, 1.0 * box.y + box.height},
+    };
+
+    double x1 = INFINITY, y1 = INFINITY, x2 = -INFINITY, y2 = -INFINITY;
+    for (auto& corner : corners)
+    {
+        auto p = transform_point_affine(matrix, corner);
+        x1 = std::min(x1, p.x);
+        y1 = std::min(y1, p.y);
+        x2 = std::max(x2, p.x);
+        y2 = std::max(y2, p.y);
+    }
+
+    wlr_box result;
+    result.x     = std::floor(x1);
+    result.y     = std::floor(y1);
+    result.width = (int)std::ceil(x2) - result.x;
+    result.height = (int)std::ceil(y2) - result.y;
+
+    return result;
+}
+
 wlr_box wf::view_interface_t::get_bounding_box()
 {
-    return transform_region(get_untransformed_bounding_box());
+    if (!view_impl->transforms.size())
+    {
+        return get_untransformed_bounding_box();
+    }
+
+    return get_transform_cache(this).bounding_box;
 }
 
 #define INVALID_COORDS(p) (std::isnan(p.x) || std::isnan(p.y))
@@ -297,20 +432,28 @@ wf::pointf_t wf::view_interface_t::global_to_local_point(const wf::pointf_t& arg
     wf::pointf_t result = arg;
     if (view_impl->transforms.size())
     {
-        auto box = get_untransformed_bounding_box();
-        /* FIXME: bounding box is not computed properly!!! It should be
-         * reverse */
-        view_impl->transforms.for_each_reverse([&] (auto& tr)
+        auto& cache = get_transform_cache(this);
+        if (cache.invertible)
         {
-            if (INVALID_COORDS(result))
+            result = transform_point_affine(cache.inverse, result);
+        } else if (cache.affine)
+        {
+            return {wf::compositor_core_t::invalid_coordinate,
+                wf::compositor_core_t::invalid_coordinate};
+        } else
+        {
+            /* Each transformer gets the bounding box it was applied to */
+            size_t idx = cache.boxes.size();
+            view_impl->transforms.for_each_reverse([&] (auto& tr)
             {
-                return;
-            }
-
-            auto& transform = tr->transform;
-            result = transform->untransform_point(box, result);
-            box    = transform->get_bounding_box(box, box);
-        });
+                --idx;
+                if (!INVALID_COORDS(result))
+                {
+                    result = tr->transform->untransform_point(cache.boxes[idx],
+                        result);
+                }
+            });
+        }
 
         if (INVALID_COORDS(result))
         {
@@ -347,19 +490,23 @@ wf::surface_interface_t*wf::view_interface_t::map_input_coordinates(
     auto view_relative_coordinates =
         global_to_local_point(cursor, nullptr);
 
-    for (auto& child : enumerate_surfaces({0, 0}))
+    wf::surface_interface_t *result = nullptr;
+    for_each_surface([&] (wf::surface_interface_t *surface, wf::point_t position)
     {
-        local.x = view_relative_coordinates.x - child.position.x;
-        local.y = view_relative_coordinates.y - child.position.y;
+        local.x = view_relative_coordinates.x - position.x;
+        local.y = view_relative_coordinates.y - position.y;
 
-        if (child.surface->accepts_input(
-            std::floor(local.x), std::floor(local.y)))
+        if (surface->accepts_input(std::floor(local.x), std::floor(local.y)))
         {
-            return child.surface;
+            result = surface;
+
+            return false;
         }
-    }
 
-    return nullptr;
+        return true;
+    });
+
+    return result;
 }
 
 bool wf::view_interface_t::is_focuseable() const
@@ -869,6 +1016,7 @@ void wf::view_interface_t::add_transformer(
         return view_impl->transforms.INSERT_NONE;
     });
 
+    ++view_impl->transformer_generation;
     damage();
 }
 
@@ -895,6 +1043,9 @@ void wf::view_interface_t::pop_transformer(
         return tr->transform.get() == transformer.get();
     });
 
+    ++view_impl->transformer_generation;
+    view_impl->opaque_cache.invalidate();
+
     /* Since we can remove transformers while rendering the output, damaging it
      * won't help at this stage (damage is already calculated).
      *
@@ -917,7 +1068,7 @@ bool wf::view_interface_t::has_transformer()
 
 wf::geometry_t wf::view_interface_t::get_untransformed_bounding_box()
 {
-    if (!is_mapped())
+    if (!is_mapped() || view_impl->frozen_counter)
     {
         return view_impl->offscreen_buffer.geometry;
     }
@@ -925,12 +1076,13 @@ wf::geometry_t wf::view_interface_t::get_untransformed_bounding_box()
     auto bbox = get_output_geometry();
     wf::region_t bounding_region = bbox;
 
-    for (auto& child : enumerate_surfaces({bbox.x, bbox.y}))
+    for_each_surface([&] (wf::surface_interface_t *surface, wf::point_t position)
     {
-        auto dim = child.surface->get_size();
-        bounding_region |= {child.position.x, child.position.y,
-            dim.width, dim.height};
-    }
+        auto dim = surface->get_size();
+        bounding_region |= {position.x, position.y, dim.width, dim.height};
+
+        return true;
+    }, {bbox.x, bbox.y});
 
     return wlr_box_from_pixman_box(bounding_region.get_extents());
 }
@@ -949,9 +1101,19 @@ wlr_box wf::view_interface_t::get_bounding_box(
 wlr_box wf::view_interface_t::transform_region(const wlr_box& region,
     nonstd::observer_ptr<wf::view_transformer_t> upto)
 {
-    auto box  = region;
-    auto view = get_untransformed_bounding_box();
+    if (!view_impl->transforms.size())
+    {
+        return region;
+    }
+
+    auto& cache = get_transform_cache(this);
+    if (cache.affine && !upto)
+    {
+        return transform_box_affine(cache.forward, region);
+    }
 
+    auto box = region;
+    size_t idx = 0;
     bool computed_region = false;
     view_impl->transforms.for_each([&] (auto& tr)
     {
@@ -962,8 +1124,7 @@ wlr_box wf::view_interface_t::transform_region(const wlr_box& region,
             return;
         }
 
-        box  = tr->transform->get_bounding_box(view, box);
-        view = tr->transform->get_bounding_box(view, view);
+        box = tr->transform->get_bounding_box(cache.boxes[idx++], box);
     });
 
     return box;
@@ -983,13 +1144,22 @@ wlr_box wf::view_interface_t::transform_region(const wlr_box& region)
 
 wf::pointf_t wf::view_interface_t::transform_point(const wf::pointf_t& point)
 {
-    auto result = point;
-    auto view   = get_untransformed_bounding_box();
+    if (!view_impl->transforms.size())
+    {
+        return point;
+    }
 
+    auto& cache = get_transform_cache(this);
+    if (cache.affine)
+    {
+        return transform_point_affine(cache.forward, point);
+    }
+
+    auto result = point;
+    size_t idx  = 0;
     view_impl->transforms.for_each([&] (auto& tr)
     {
-        result = tr->transform->transform_point(view, result);
-        view   = tr->transform->get_bounding_box(view, view);
+        result = tr->transform->transform_point(cache.boxes[idx++], result);
     });
 
     return result;
@@ -1004,72 +1174,186 @@ bool wf::view_interface_t::intersects_region(const wlr_box& region)
     }
 
     auto origin = get_output_geometry();
-    for (auto& child : enumerate_surfaces({origin.x, origin.y}))
+
+    /* The iteration stops at the first intersecting surface */
+    return !for_each_surface([&] (wf::surface_interface_t *surface,
+                                  wf::point_t position)
     {
-        wlr_box box = {child.position.x, child.position.y,
-            child.surface->get_size().width, child.surface->get_size().height};
+        wlr_box box = {position.x, position.y,
+            surface->get_size().width, surface->get_size().height};
         box = transform_region(box);
 
-        if (region & box)
-        {
-            return true;
-        }
-    }
-
-    return false;
+        return !(region & box);
+    }, {origin.x, origin.y});
 }
 
 wf::region_t wf::view_interface_t::get_transformed_opaque_region()
 {
-    if (!is_mapped())
+    /* The snapshot of frozen views is not necessarily opaque */
+    if (!is_mapped() || view_impl->frozen_counter)
     {
         return {};
     }
 
-    auto obox = get_untransformed_bounding_box();
-    auto og   = get_output_geometry();
+    auto& cache = view_impl->opaque_cache;
+    auto og = get_output_geometry();
+
+    /* Check whether any surface has changed since the cache was computed */
+    bool up_to_date = true;
+    size_t idx = 0;
+    for_each_surface([&] (wf::surface_interface_t *surface, wf::point_t position)
+    {
+        up_to_date = (idx < cache.surfaces.size()) &&
+            (cache.surfaces[idx].surface == surface) &&
+            (cache.surfaces[idx].opaque_serial == surface->priv->opaque_serial) &&
+            (cache.surfaces[idx].position == position);
+        ++idx;
+
+        return up_to_date;
+    }, {og.x, og.y});
+
+    up_to_date &= (idx == cache.surfaces.size());
+
+    /* The cache is keyed on the transformers too, including their absence,
+     * so that a region transformed by a removed transformer is not reused */
+    const transform_cache_t *transform_cache = nullptr;
+    uint64_t transform_version = cache.NO_TRANSFORMERS;
+    if (view_impl->transforms.size())
+    {
+        transform_cache   = &get_transform_cache(this);
+        transform_version = transform_cache->version;
+        up_to_date &= transform_cache->valid;
+    }
+
+    up_to_date &= (transform_version == cache.transform_version);
+    cache.transform_version = transform_version;
+
+    if (!up_to_date)
+    {
+        cache.regions.clear();
+        cache.surfaces.clear();
+        for_each_surface([&] (wf::surface_interface_t *surface,
+                              wf::point_t position)
+        {
+            cache.surfaces.push_back({surface, surface->priv->opaque_serial,
+                position});
+
+            return true;
+        }, {og.x, og.y});
+    }
+
+    int shrink = get_active_shrink_constraint();
+    for (auto& [cached_shrink, region] : cache.regions)
+    {
+        if (cached_shrink == shrink)
+        {
+            return region;
+        }
+    }
 
     wf::region_t opaque;
-    for (auto& surf : enumerate_surfaces({og.x, og.y}))
+    for (auto& state : cache.surfaces)
     {
-        opaque |= surf.surface->get_opaque_region(surf.position);
+        opaque |= state.surface->get_opaque_region(state.position);
     }
 
-    auto bbox = obox;
-    this->view_impl->transforms.for_each(
-        [&] (const std::shared_ptr<view_transform_block_t> tr)
+    if (transform_cache)
     {
-        opaque = tr->transform->transform_opaque_region(bbox, opaque);
-        bbox   = tr->transform->get_bounding_box(bbox, bbox);
-    });
+        idx = 0;
+        this->view_impl->transforms.for_each(
+            [&] (const std::shared_ptr<view_transform_block_t> tr)
+        {
+            opaque = tr->transform->transform_opaque_region(
+                transform_cache->boxes[idx++], opaque);
+        });
+    }
+
+    cache.regions.push_back({shrink, opaque});
 
     return opaque;
 }
 
+/** @return true if the surface tree of the view contains just one surface */
+static bool has_single_surface(wf::view_interface_t *view)
+{
+    int count = 0;
+    view->for_each_surface([&] (wf::surface_interface_t*, wf::point_t)
+    {
+        return ++count < 2;
+    });
+
+    return count == 1;
+}
+
 bool wf::view_interface_t::render_transformed(const wf::framebuffer_t& framebuffer,
     const wf::region_t& damage)
 {
-    if (!is_mapped() && !view_impl->offscreen_buffer.valid())
+    bool frozen = (view_impl->frozen_counter > 0);
+    if ((!is_mapped() || frozen) && !view_impl->offscreen_buffer.valid())
     {
         return false;
     }
 
     wf::geometry_t obox = get_untransformed_bounding_box();
     wf::texture_t previous_texture;
-    float texture_scale;
+    /* The scale of the intermediate transformer buffers. It matches the source
+     * texture, so that no detail is lost before the last transformer. */
+    float buffer_scale;
 
-    if (is_mapped() && (enumerate_surfaces().size() == 1) && get_wlr_surface())
+    std::shared_ptr<view_transform_block_t> first_transform = nullptr;
+    view_impl->transforms.for_each([&] (auto& transform)
+    {
+        if (!first_transform)
+        {
+            first_transform = transform;
+        }
+    });
+
+    /* If the view is displayed at a fraction of its size, start with a cached
+     * downscaled copy instead of sampling the full-resolution contents */
+    bool use_thumbnail = false;
+    if (first_transform && get_output() && !frozen)
+    {
+        auto displayed = first_transform->transform->get_displayed_size(obox);
+        use_thumbnail = (displayed.width > 0) && (displayed.height > 0) &&
+            (displayed.width * 2 <= obox.width) &&
+            (displayed.height * 2 <= obox.height);
+
+        if (use_thumbnail)
+        {
+            float scale    = get_output()->handle->scale;
+            auto thumbnail = view_thumbnail_t::get(self());
+            previous_texture = thumbnail->get_texture({
+                (int)std::ceil(displayed.width * scale),
+                (int)std::ceil(displayed.height * scale),
+            });
+
+            use_thumbnail = (previous_texture.tex_id != (GLuint)-1);
+
+            /* The thumbnail is already shrunk close to the displayed size,
+             * while the boxes of the transformers are not. Intermediate
+             * buffers thus use the output scale, as the transformed boxes
+             * already account for the shrinking. */
+            buffer_scale = scale;
+        }
+    }
+
+    if (use_thumbnail)
+    {
+        /* previous_texture is already set */
+    } else if (is_mapped() && !frozen && has_single_surface(this) &&
+               get_wlr_surface())
     {
         /* Optimized case: there is a single mapped surface.
          * We can directly start with its texture */
         previous_texture =
             wf::texture_t{this->get_wlr_surface()->buffer->texture};
-        texture_scale = this->get_wlr_surface()->current.scale;
+        buffer_scale = this->get_wlr_surface()->current.scale;
     } else
     {
         take_snapshot();
         previous_texture = wf::texture_t{view_impl->offscreen_buffer.tex};
-        texture_scale    = view_impl->offscreen_buffer.scale;
+        buffer_scale     = view_impl->offscreen_buffer.scale;
     }
 
     /* We keep a shared_ptr to the previous transform which we executed, so that
@@ -1100,13 +1384,13 @@ bool wf::view_interface_t::render_transformed(const wf::framebuffer_t& framebuff
         /* Calculate size after this transform */
         auto transformed_box =
             transform->transform->get_bounding_box(obox, obox);
-        int scaled_width  = transformed_box.width * texture_scale;
-        int scaled_height = transformed_box.height * texture_scale;
+        int scaled_width  = transformed_box.width * buffer_scale;
+        int scaled_height = transformed_box.height * buffer_scale;
 
         /* Prepare buffer to store result after the transform */
         OpenGL::render_begin();
         transform->fb.allocate(scaled_width, scaled_height);
-        transform->fb.scale    = texture_scale;
+        transform->fb.scale    = buffer_scale;
         transform->fb.geometry = transformed_box;
         transform->fb.bind(); // bind buffer to clear it
         OpenGL::clear({0, 0, 0, 0});
@@ -1168,7 +1452,8 @@ wf::view_transform_block_t::~view_transform_block_t()
 
 void wf::view_interface_t::take_snapshot()
 {
-    if (!is_mapped())
+    /* Frozen views keep the snapshot they had when they were frozen */
+    if (!is_mapped() || view_impl->frozen_counter)
     {
         return;
     }
@@ -1208,20 +1493,21 @@ void wf::view_interface_t::take_snapshot()
     OpenGL::render_end();
 
     auto output_geometry = get_output_geometry();
-    auto children = enumerate_surfaces({output_geometry.x, output_geometry.y});
-    for (auto& child : wf::reverse(children))
+    for_each_surface_reverse([&] (wf::surface_interface_t *surface,
+                                  wf::point_t position)
     {
         wlr_box child_box{
-            child.position.x,
-            child.position.y,
-            child.surface->get_size().width,
-            child.surface->get_size().height
+            position.x,
+            position.y,
+            surface->get_size().width,
+            surface->get_size().height
         };
 
-        child.surface->simple_render(offscreen_buffer,
-            child.position.x, child.position.y,
+        surface->simple_render(offscreen_buffer, position.x, position.y,
             offscreen_buffer.cached_damage & child_box);
-    }
+
+        return true;
+    }, {output_geometry.x, output_geometry.y});
 
     offscreen_buffer.cached_damage.clear();
 }
@@ -1282,6 +1568,7 @@ void wf::view_interface_t::damage_surface_box(const wlr_box& box)
     damaged.x += obox.x;
     damaged.y += obox.y;
     view_impl->offscreen_buffer.cached_damage |= damaged;
+    ++view_impl->content_damage_serial;
     view_damage_raw(self(), transform_region(damaged));
 }
 
@@ -1320,6 +1607,43 @@ void wf::view_damage_raw(wayfire_view view, const wlr_box& box)
     view->emit_signal("region-damaged", nullptr);
 }
 
+void wf::view_set_frozen(wayfire_view view, bool frozen)
+{
+    auto& impl = view->view_impl;
+    if (frozen)
+    {
+        if ((impl->frozen_counter == 0) && view->is_mapped() &&
+            view->get_output())
+        {
+            /* The snapshot has to match the current contents exactly */
+            impl->offscreen_buffer.cached_damage |=
+                view->get_untransformed_bounding_box();
+            view->take_snapshot();
+        }
+
+        ++impl->frozen_counter;
+
+        return;
+    }
+
+    if (impl->frozen_counter <= 0)
+    {
+        LOGE("View thawed more times than it was frozen!");
+
+        return;
+    }
+
+    /* Damage both the snapshot and the current contents */
+    view->damage();
+    --impl->frozen_counter;
+    view->damage();
+}
+
+bool wf::view_is_frozen(wayfire_view view)
+{
+    return view->view_impl->frozen_counter > 0;
+}
+
 void wf::view_interface_t::destruct()
 {
     view_impl->is_alive = false;
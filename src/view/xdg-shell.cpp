@@ -311,6 +311,14 @@ void wayfire_xdg_view::commit()
     }
 
     this->last_size_request = wf::dimensions(xdg_g);
+    flush_deferred_resize();
+}
+
+bool wayfire_xdg_view::is_configure_acked()
+{
+    /* Serials may wrap around */
+    return (int32_t)(xdg_toplevel->base->configure_serial -
+        last_size_serial) >= 0;
 }
 
 wf::point_t wayfire_xdg_view::get_window_offset()
@@ -372,6 +380,11 @@ void wayfire_xdg_view::set_fullscreen(bool full)
 
 void wayfire_xdg_view::resize(int w, int h)
 {
+    if (defer_resize({w, h}))
+    {
+        return;
+    }
+
     if (view_impl->frame)
     {
         view_impl->frame->calculate_resize_size(w, h);
@@ -382,7 +395,8 @@ void wayfire_xdg_view::resize(int w, int h)
     if (should_resize_client({w, h}, current_size))
     {
         this->last_size_request = {w, h};
-        wlr_xdg_toplevel_set_size(xdg_toplevel->base, w, h);
+        last_size_serial = wlr_xdg_toplevel_set_size(xdg_toplevel->base, w, h);
+        notify_size_configured();
     }
 }
 
@@ -46,9 +46,12 @@ class wayfire_xdg_view : public wf::wlr_view_t
 
     wf::point_t xdg_surface_offset = {0, 0};
     wlr_xdg_toplevel *xdg_toplevel;
+    /** The serial of the last configure with a new size */
+    uint32_t last_size_serial = 0;
 
   protected:
     void initialize() override final;
+    bool is_configure_acked() override final;
 
   public:
     wayfire_xdg_view(wlr_xdg_toplevel *toplevel);
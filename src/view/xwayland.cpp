@@ -12,8 +12,130 @@
 #include "../core/seat/input-manager.hpp"
 #include "view-impl.hpp"
 
+#include <chrono>
+#include <signal.h>
+
 #if WF_HAS_XWAYLAND
 
+static wlr_xwayland *xwayland_handle = nullptr;
+
+/**
+ * Stops the Xwayland server when no X11 windows have existed for
+ * core/xwayland_idle_timeout seconds.
+ *
+ * The server is created in lazy mode, so that wlroots starts Xwayland only
+ * when the first X11 client connects to the display socket. When an idle
+ * server is terminated, wlroots keeps the sockets and goes back to listening
+ * on them, so DISPLAY stays valid and the next client transparently starts
+ * a new server. Atoms, seat and cursor are set up again when the new server
+ * is ready, and the views of the old server are destroyed together with its
+ * surfaces.
+ *
+ * Note that X11 clients without any windows do not keep the server alive.
+ */
+class xwayland_lifecycle_t
+{
+    wf::option_wrapper_t<int> idle_timeout{"core/xwayland_idle_timeout"};
+
+    /** wlroots restarts a lazy server only if it ran for longer than this */
+    static constexpr auto MIN_SERVER_LIFETIME = std::chrono::seconds(6);
+
+    /**
+     * Whether the server was created lazily. This is decided once, as wlroots
+     * restarts only lazily created servers, so an eagerly started server must
+     * never be terminated.
+     */
+    const bool lazy = (idle_timeout > 0);
+
+    int surface_count = 0;
+    bool server_running = false;
+    std::chrono::steady_clock::time_point server_ready_time;
+    wf::wl_timer idle_timer;
+
+    void schedule_teardown(int timeout_ms)
+    {
+        idle_timer.disconnect();
+        if (!lazy || (timeout_ms <= 0))
+        {
+            return;
+        }
+
+        idle_timer.set_timeout(timeout_ms, [=] ()
+        {
+            teardown();
+        });
+    }
+
+    void teardown()
+    {
+        if (!lazy || (surface_count > 0) || !server_running ||
+            !xwayland_handle->server || !xwayland_handle->server->client)
+        {
+            return;
+        }
+
+        auto elapsed = std::chrono::steady_clock::now() - server_ready_time;
+        if (elapsed < MIN_SERVER_LIFETIME)
+        {
+            /* Terminating the server now would leave X11 unusable */
+            schedule_teardown(std::chrono::duration_cast<std::chrono::milliseconds>(
+                MIN_SERVER_LIFETIME - elapsed).count() + 1);
+
+            return;
+        }
+
+        LOGI("Terminating idle Xwayland server");
+        server_running = false;
+        kill(xwayland_handle->server->pid, SIGTERM);
+    }
+
+  public:
+    /** @return Whether Xwayland should be started lazily and stopped when idle */
+    bool is_lazy() const
+    {
+        return lazy;
+    }
+
+    /**
+     * Schedule terminating the server once the idle timeout expires. The
+     * timeout is read each time, so changes apply to lazy servers at runtime.
+     * A timeout of 0 keeps the lazy server running.
+     */
+    void schedule_idle_teardown()
+    {
+        schedule_teardown(idle_timeout * 1000);
+    }
+
+    void server_ready()
+    {
+        server_running    = true;
+        server_ready_time = std::chrono::steady_clock::now();
+
+        /* Clients may connect without ever creating a window */
+        if (surface_count == 0)
+        {
+            schedule_idle_teardown();
+        }
+    }
+
+    void surface_created()
+    {
+        ++surface_count;
+        idle_timer.disconnect();
+    }
+
+    void surface_destroyed()
+    {
+        --surface_count;
+        if (surface_count == 0)
+        {
+            schedule_idle_teardown();
+        }
+    }
+};
+
+static std::unique_ptr<xwayland_lifecycle_t> xwayland_lifecycle;
+
 class wayfire_xwayland_view_base : public wf::wlr_view_t
 {
   protected:
@@ -123,6 +245,7 @@ class wayfire_xwayland_view_base : public wf::wlr_view_t
     virtual void initialize() override
     {
         wf::wlr_view_t::initialize();
+        xwayland_lifecycle->surface_created();
         on_map.set_callback([&] (void*) { map(xw->surface); });
         on_unmap.set_callback([&] (void*) { unmap(); });
         on_destroy.set_callback([&] (void*) { destroy(); });
@@ -227,6 +350,11 @@ class wayfire_xwayland_view_base : public wf::wlr_view_t
 
     virtual void destroy() override
     {
+        if (this->xw)
+        {
+            xwayland_lifecycle->surface_destroyed();
+        }
+
         this->xw = nullptr;
         output_geometry_changed.disconnect();
 
@@ -634,6 +762,7 @@ class wayfire_xwayland_view : public wayfire_xwayland_view_base
         /* Avoid loops where the client wants to have a certain size but the
          * compositor keeps trying to resize it */
         last_size_request = wf::dimensions(geometry);
+        flush_deferred_resize();
     }
 
     void set_moving(bool moving) override
@@ -650,6 +779,11 @@ class wayfire_xwayland_view : public wayfire_xwayland_view_base
 
     void resize(int w, int h) override
     {
+        if (defer_resize({w, h}))
+        {
+            return;
+        }
+
         if (view_impl->frame)
         {
             view_impl->frame->calculate_resize_size(w, h);
@@ -666,6 +800,7 @@ class wayfire_xwayland_view : public wayfire_xwayland_view_base
 
         this->last_size_request = {w, h};
         send_configure(w, h);
+        notify_size_configured();
     }
 
     virtual void request_native_size() override
@@ -884,8 +1019,6 @@ void wayfire_xwayland_view_base::recreate_view_with_or_type()
         raw_ptr->map(xw_surf->surface);
     }
 }
-
-static wlr_xwayland *xwayland_handle = nullptr;
 #endif
 
 void wf::init_xwayland()
@@ -921,16 +1054,18 @@ void wf::init_xwayland()
             LOGE("Failed to load Xwayland atoms.");
         } else
         {
-            LOGD("Successfully loaded Xwayland atoms.");
+            LOGC(XWL, "Successfully loaded Xwayland atoms.");
         }
 
         wlr_xwayland_set_seat(xwayland_handle,
             wf::get_core().get_current_seat());
         xwayland_update_default_cursor();
+        xwayland_lifecycle->server_ready();
     });
 
-    xwayland_handle = wlr_xwayland_create(wf::get_core().display,
-        wf::get_core_impl().compositor, false);
+    xwayland_lifecycle = std::make_unique<xwayland_lifecycle_t>();
+    xwayland_handle    = wlr_xwayland_create(wf::get_core().display,
+        wf::get_core_impl().compositor, xwayland_lifecycle->is_lazy());
 
     if (xwayland_handle)
     {